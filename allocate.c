@@ -1,384 +1,887 @@
 #include "allocate.h"
 #include "queues.h"
-
-int main (int argc, char *argv[]) {
-    int opt, strategy = SJF, memory_strategy = INFINITE, quantum;
-    FILE *inFile;
-
-    while ((opt = getopt(argc, argv, "f:s:m:q:")) != -1) {
-        switch (opt) {
-            case 'f': // Open and read input file
-                inFile = fopen(optarg, "r");
-                break;
-            case 's': // strategy
-                // 0 for SJF, 1 for RR
-                if (strcmp(optarg, "RR") == 0) strategy = RR;
-                break;
-            case 'm': // allocate memory
-                // 0 for infinite, 1 for best fit
-                if (strcmp(optarg, "best-fit") == 0) memory_strategy = BESTFIT;
-                break;
-            case 'q': // quantum
-                quantum = atoi(optarg);
-                break;
-            default:
-                fprintf(stderr, "Missing argument\n");
-                exit(EXIT_FAILURE);
+#include "checkpoint.h"
+
+/* Creates the queues, memory and pools of one simulation run, the caller opens its trace or
+   submits its processes */
+simulation_t* make_simulation(config_t *config, writer_t *out) {
+    simulation_t *sim = malloc(sizeof(simulation_t));
+    assert(sim!=NULL);
+
+    sim->config = *config;
+    if (sim->config.cpus < 1) sim->config.cpus = 1;
+    if (sim->config.mlfq_levels < 1) sim->config.mlfq_levels = MLFQ_LEVELS;
+    for (int i = 0; i < sim->config.mlfq_levels; i++) {
+        if (sim->config.mlfq_slices[i] < 1) {
+            sim->config.mlfq_slices[i] = (int64_t)config->quantum << (i < 16 ? i : 16);
         }
-    } 
-
-    if (inFile == NULL) {
-        fprintf(stderr, "Input file error\n");
-        exit(EXIT_FAILURE);
     }
-
-    queue_t *infile_q = make_empty_queue();
-    queue_t *input_q = make_empty_queue();
-    queue_t *ready_q = make_empty_queue();
-    segment_t *simulated_memory = initialize_simulated_memory(memory_strategy);
-
-    char *lineptr = NULL;
-    size_t lineBufferLength = 0;
-    char *delim = " ";
-
-    while(getline(&lineptr, &lineBufferLength, inFile) != -1) {
-        process_t *process = build_process(lineptr, delim);
-        enqueue_process(infile_q, process);
+    if (sim->config.mlfq_boost < 1) sim->config.mlfq_boost = MLFQ_BOOST_CYCLES * (int64_t)config->quantum;
+    if (sim->config.granularity < MIN_GRANULARITY) sim->config.granularity = MEMORY_GRANULARITY;
+    sim->next_boost = sim->config.mlfq_boost;
+    sim->out = out;
+    sim->trace = NULL;
+
+    // process slots and names are recycled as processes finish, and released at the end
+    sim->processes = make_process_table();
+    sim->name_arena = make_arena();
+    sim->processes->name_arena = sim->name_arena;
+
+    sim->input_q = make_empty_queue(sim->processes);
+
+    // every CPU has its own ready queue
+    sim->cpus = calloc(sim->config.cpus, sizeof(cpu_t));
+    assert(sim->cpus!=NULL);
+    for (int i = 0; i < sim->config.cpus; i++) {
+        sim->cpus[i].id = i;
+        sim->cpus[i].running = NO_PROCESS;
+        sim->cpus[i].ready_q = make_ready_queue(config->strategy, sim->config.mlfq_levels,
+            sim->config.mlfq_slices, sim->processes);
     }
-    free(lineptr);
-    lineptr = NULL;
 
-    fclose(inFile);
+    sim->stats = NULL;
+    STAT_ONLY(sim->stats = make_stats();)
+    sim->allocator = make_allocator(config->memory_strategy, sim->config.memory_mb, sim->config.granularity,
+        sim->stats);
+    sim->admission.generation = 0;
+    sim->admission.tried_foot = NO_PROCESS;
+    sim->admission.tried_count = 0;
+    sim->admission.compact = config->compaction && sim->allocator && allocator_can_compact(config->memory_strategy);
+    sim->admission.compactions = sim->admission.compacted_mb = sim->admission.compaction_stall = 0;
+    sim->admission.backfill = config->admission == BACKFILL;
+    sim->admission.reserved = NO_PROCESS;
+    sim->admission.reservation_time = sim->admission.shadow_time = sim->admission.extra_mb = 0;
+    sim->admission.reservations = sim->admission.reservation_hits = sim->admission.reservation_misses = 0;
+    sim->admission.releases = NULL;
+    sim->admission.holders = NULL;
+    sim->admission.release_count = sim->admission.releases_capacity = 0;
+
+    sim->simulated_time = sim->num_cycles = sim->turnaround_time = sim->num_processes = 0;
+    sim->total_overhead = sim->max_overhead = 0;
+    sim->horizon = INT64_MAX;
+    sim->checkpoint_file = NULL;
+    sim->checkpoint_at = 0;
+    sim->executor = NULL;
+    sim->error[0] = '\0';
+
+    memset(&sim->results, 0, sizeof(results_t));
+
+    // the overhead ratio is kept to thousandths
+    sim->histograms = NULL;
+    if (config->histograms) {
+        sim->histograms = malloc(HISTOGRAM_COUNT * sizeof(histogram_t));
+        assert(sim->histograms!=NULL);
+        for (int i = 0; i < HISTOGRAM_COUNT; i++) {
+            init_histogram(&sim->histograms[i], i == HISTOGRAM_OVERHEAD ? HISTOGRAM_OVERHEAD_SCALE : 1);
+        }
+    }
 
-    schedule_processes(infile_q, input_q, ready_q, strategy, quantum, simulated_memory, memory_strategy);
+    return sim;
+}
 
-    free(infile_q);
-    free(input_q);
-    free(ready_q);
+void free_simulation(simulation_t *sim) {
+    if (sim->trace) close_trace(sim->trace);
+    free(sim->input_q);
+    for (int i = 0; i < sim->config.cpus; i++) free_ready_queue(sim->cpus[i].ready_q);
+    free(sim->cpus);
+
+    if (sim->allocator) free_allocator(sim->allocator);
+    free(sim->admission.releases);
+    free(sim->admission.holders);
+
+    free_process_table(sim->processes);
+    free_arena(sim->name_arena);
+    if (sim->stats) free_stats(sim->stats);
+    free(sim->histograms);
+    if (sim->executor) free_executor(sim->executor);
+    free(sim);
+}
 
-    segment_t *head = simulated_memory, *to_free;
-    while (head) {
-        to_free = head;
-        head = head->next_s;
-        free(to_free);
-    }
+/* MLFQ boosts in cycles about to be skipped, which find no process waiting. Returns the number of
+   the skipped cycle the last of them comes in, -1 if none does, and moves the next boost past it */
+static int64_t skip_boosts(simulation_t *sim, int64_t simulated_time, int64_t skipped_cycles) {
+    int64_t period = sim->config.mlfq_boost;
+    int quantum = sim->config.quantum;
+    int64_t last_cycle = simulated_time + (skipped_cycles - 1) * quantum;
+    if (sim->next_boost > last_cycle) return -1;
+
+    // once due, boosts come in the first cycle from each multiple of the period
+    int64_t boost_time = last_cycle / period * period;
+    int64_t cycle = boost_time > simulated_time ? cycles_to_cover(boost_time - simulated_time, quantum) : 0;
+    sim->next_boost = ((simulated_time + cycle * quantum) / period + 1) * period;
+    return cycle;
+}
 
-    return 0;
+/* Stops a simulation, keeping why in sim->error for the caller to report */
+static int fail_simulation(simulation_t *sim, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    vsnprintf(sim->error, sizeof(sim->error), format, args);
+    va_end(args);
+    return -1;
 }
 
-/* Process scheduling */
-void schedule_processes(queue_t *infile_q, queue_t *input_q, queue_t *ready_q, 
-    int strategy, int quantum, segment_t *memory, int memory_strategy) {
-
-    int num_cycles = 0;
-    int simulated_time = 0;
-    int turnaround_time = 0;
-    int num_processes = 0;
-    double total_overhead = 0, max_overhead = 0;
-
-    process_t *running_process = NULL;
-
-    // Each loop is 1 cycle
-    do {
-        // 1 - if running process is completed, terminate and deallocate memory
-        if (running_process) {
-            if (is_process_finished(running_process)) {
-                // terminate program, move to finished state
-                turnaround_time += running_process->time_ran;
-                turnaround_time += running_process->wait_time;
-                
-                double temp_overhead = (running_process->time_ran
-                 + running_process->wait_time)
-                 /(double)running_process->service_time;
-                total_overhead += temp_overhead;
-                max_overhead = fmax(temp_overhead, max_overhead);
-
-                running_process->state = FINISHED;
-                print_finished_process(simulated_time, running_process->process_name, ready_q->count + input_q->count);
-
-                // Merge holes
-                merge_memory_holes(memory);
-                
-                free_process(running_process);
-                running_process = NULL;
+/* Runs one cycle of a simulation, with event-driven time advance the first cycle in which something
+   can happen. Returns 0 once every process submitted so far has finished, and -1 with sim->error
+   set if the run cannot go on */
+int step_simulation(simulation_t *sim) {
+    if (sim->error[0]) return -1;
+    if (sim->trace == NULL) sim->trace = open_submitted_trace(sim->processes, sim->name_arena);
+
+    trace_t *trace = sim->trace;
+    queue_t *input_q = sim->input_q;
+    cpu_t *cpus = sim->cpus;
+    allocator_t *allocator = sim->allocator;
+    writer_t *out = sim->out;
+    int strategy = sim->config.strategy, memory_strategy = sim->config.memory_strategy;
+    int quantum = sim->config.quantum, time_advance = sim->config.time_advance;
+    int cpu_count = sim->config.cpus;
+    process_table_t *table = sim->processes;
+    histogram_t *histograms = sim->histograms;
+    histogram_t *admission_delays = histograms ? &histograms[HISTOGRAM_ADMISSION] : NULL;
+
+    // progress is kept in locals while the cycle runs
+    int64_t num_cycles = sim->num_cycles;
+    int64_t simulated_time = sim->simulated_time;
+    int64_t turnaround_time = sim->turnaround_time;
+    int64_t num_processes = sim->num_processes;
+    double total_overhead = sim->total_overhead, max_overhead = sim->max_overhead;
+
+    STAT_DECLARE(stats_t *stats = sim->stats; double phase_start = stats_now());
+
+    // Jump over the cycles since the last one in which no process can arrive, finish or be switched.
+    // It is left to the next step so processes submitted in between are seen
+    if (time_advance == EVENT && num_cycles > 0) {
+        int64_t next_time = next_event_time(trace, input_q, cpus, cpu_count,
+            strategy, memory_strategy, simulated_time, quantum, sim->next_boost);
+        // memory freed, compacted or made evictable since the last admission pass is tried at once
+        if (allocator && allocator->generation != sim->admission.generation && !queue_is_empty(input_q)) {
+            next_time = simulated_time;
+        }
+        if (next_time > sim->horizon) next_time = sim->horizon;
+        int64_t skipped_cycles = (next_time - simulated_time) / quantum;
+
+        if (skipped_cycles > 0) {
+            // MLFQ boosts and slices used up still change the levels of the running processes
+            int64_t boost_cycle = strategy == MLFQ ? skip_boosts(sim, simulated_time, skipped_cycles) : -1;
+
+            for (int c = 0; c < cpu_count; c++) {
+                handle_t p = cpus[c].running;
+                if (p == NO_PROCESS) {
+                    STAT_ADD(stats, idle_cycles, skipped_cycles);
+                    continue;
+                }
+                int level = table->level[p];
+                int64_t slice_used = table->slice_used[p];
+                run_cpu(&cpus[c], skipped_cycles * quantum);
+
+                if (strategy == MLFQ && boost_cycle >= 0) {
+                    mlfq_skip_cycles(cpus[c].ready_q->mlfq, p, 0, 0, skipped_cycles - boost_cycle, quantum);
+                } else if (strategy == MLFQ) {
+                    mlfq_skip_cycles(cpus[c].ready_q->mlfq, p, level, slice_used, skipped_cycles, quantum);
+                }
             }
+            simulated_time += skipped_cycles * quantum;
+            num_cycles += skipped_cycles;
         }
+    }
 
-        // 2 - Identify new processes to add to input queue
-        // only when arrival time <= simulated time
-        add_to_input_q(infile_q, input_q, simulated_time, &num_processes);
-
-        // 3 - Move process from input to ready queue upon successful memory allocation
-        // Depending on memory strategy - infinite or best fit
-        if (memory_strategy == BESTFIT) {
-            allocate_input_processes(input_q, memory, ready_q, strategy, simulated_time, quantum);
-        } else {
-            add_to_ready_q_infinite(input_q, ready_q, strategy, quantum);
+    // 0 - save the whole state once the checkpoint time is reached, before the cycle changes it
+    if (sim->checkpoint_file && simulated_time >= sim->checkpoint_at) {
+        sim->simulated_time = simulated_time;
+        sim->num_cycles = num_cycles;
+        if (write_checkpoint(sim, sim->checkpoint_file) != 0) {
+            return fail_simulation(sim, "Checkpoint file error");
         }
+        sim->checkpoint_file = NULL;
+    }
 
-        // 4 - Process scheduling
-        if (strategy == SJF) { // SJF
-            // if no running process and ready_q has process, schedule next ready
-            if (!running_process && !queue_is_empty(ready_q)) {
-                node_t *to_free = dequeue_node(ready_q);
-                running_process = to_free->p;
-                free(to_free);
-                print_running_process(simulated_time, running_process->process_name, 
-                    process_remaining_time(running_process));
-                
+    // 1 - if a running process is completed, terminate and deallocate memory
+    for (int c = 0; c < cpu_count; c++) {
+        handle_t running_process = cpus[c].running;
+        if (running_process != NO_PROCESS && is_process_finished(table, running_process)) {
+            // terminate program, move to finished state
+            turnaround_time += table->time_ran[running_process];
+            turnaround_time += table->wait_time[running_process];
+
+            double temp_overhead = (table->time_ran[running_process]
+             + table->wait_time[running_process])
+             /(double)table->service_time[running_process];
+            total_overhead += temp_overhead;
+            max_overhead = fmax(temp_overhead, max_overhead);
+            if (histograms) {
+                histogram_record(&histograms[HISTOGRAM_TURNAROUND],
+                    table->time_ran[running_process] + table->wait_time[running_process]);
+                histogram_record(&histograms[HISTOGRAM_WAIT], table->wait_time[running_process]);
+                histogram_record(&histograms[HISTOGRAM_OVERHEAD],
+                    llround(temp_overhead * histograms[HISTOGRAM_OVERHEAD].scale));
             }
+
+            table->state[running_process] = FINISHED;
+            print_finished_process(out, table, simulated_time, running_process,
+                total_ready_count(cpus, cpu_count) + input_q->count, c);
+
+            // Free its memory and merge it with neighbouring holes
+            if (table->mem_start[running_process] >= 0) allocator_release(allocator, table, running_process);
+            if (sim->executor) executor_finish(sim->executor, running_process);
+
+            release_process(trace, running_process);
+            cpus[c].running = NO_PROCESS;
+            cpus[c].last_finish = simulated_time;
         }
-        else { // RR
-            if (!queue_is_empty(ready_q)) {
-                node_t *to_free = dequeue_node(ready_q);
-                // No running process, like start of the program or when there is a gap between processes
-                if (!running_process) {
-                    running_process = to_free->p;
-                    running_process->state = RUNNING;
-                }
-                // If running process, switch out
-                else {
-                    running_process->state = READY;
-                    enqueue_process(ready_q, running_process);
-                    running_process = to_free->p;
-                    running_process->state = RUNNING;
-                }
-                free(to_free);
-                print_running_process(simulated_time, running_process->process_name, 
-                    process_remaining_time(running_process));
+    }
+
+    // 2 - Identify new processes to add to input queue
+    // only when arrival time <= simulated time
+    STAT_ONLY(stats_end_phase(stats, PHASE_ACCOUNTING, &phase_start));
+    int64_t capacity_mb = allocator ? allocator->capacity_mb : INT64_MAX;
+    handle_t too_large = add_to_input_q(trace, input_q, simulated_time, quantum, capacity_mb, &num_processes, out);
+    if (too_large != NO_PROCESS) {
+        return fail_simulation(sim, "Process %.*s needs %lld MB, more than the %lld MB memory can hold",
+            table->name_length[too_large], process_name(table, too_large),
+            (long long)table->memory_requirement[too_large], (long long)capacity_mb);
+    }
+    STAT_MAX(stats, input_q_high_water, input_q->count);
+    STAT_ONLY(stats_end_phase(stats, PHASE_ARRIVALS, &phase_start));
+
+    // 3 - Move process from input to a ready queue upon successful memory allocation
+    // Depending on memory strategy - infinite or one of the allocators
+    if (memory_strategy == INFINITE) {
+        add_to_ready_q_infinite(input_q, cpus, cpu_count, simulated_time, quantum, admission_delays);
+    } else {
+        int64_t compacted_mb = allocate_input_processes(input_q, allocator, &sim->admission, cpus,
+            cpu_count, simulated_time, quantum, out, admission_delays);
+
+        // moving memory stalls every CPU for whole cycles, the running processes wait meanwhile
+        if (compacted_mb > 0) {
+            int64_t stall = cycles_to_cover((int64_t)ceil(compacted_mb * sim->config.compaction_cost), quantum)
+                * quantum;
+            for (int c = 0; c < cpu_count; c++) {
+                if (cpus[c].running != NO_PROCESS) table->wait_time[cpus[c].running] += stall;
             }
+            simulated_time += stall;
+            num_cycles += stall / quantum;
+            sim->admission.compaction_stall += stall;
         }
+    }
+    STAT_MAX(stats, ready_q_high_water, total_ready_count(cpus, cpu_count));
+    STAT_ONLY(if (allocator && stats_sample_due(stats)) {
+        allocator_stats_t free_memory;
+        allocator_stats(allocator, &free_memory);
+        stats_sample_memory(stats, simulated_time, free_memory.holes, free_memory.free_mb,
+            free_memory.largest_hole);
+    })
+    STAT_ONLY(stats_end_phase(stats, PHASE_ALLOCATION, &phase_start));
+
+    // 4 - Process scheduling, each CPU from its own ready queue
+    // MLFQ periodically lifts every process back to the highest priority
+    if (strategy == MLFQ && simulated_time >= sim->next_boost) {
+        boost_cpus(cpus, cpu_count);
+        sim->next_boost = (simulated_time / sim->config.mlfq_boost + 1) * sim->config.mlfq_boost;
+    }
 
-        if (running_process) {
-            running_process->time_ran += quantum;
-        }
+    for (int c = 0; c < cpu_count; c++) {
+        schedule_cpu(&cpus[c], strategy, simulated_time, out, sim->stats, sim->executor, allocator);
+    }
 
-        // increment wait time in ready_q
-        node_t *curr = ready_q->head;
-        while(curr) {
-            curr->p->wait_time += quantum;
-            curr = curr->next;
+    // CPUs left idle take a process from the longest ready queue
+    for (int c = 0; c < cpu_count && cpu_count > 1; c++) {
+        if (cpus[c].running == NO_PROCESS) {
+            steal_process(cpus, cpu_count, &cpus[c], simulated_time, out, sim->stats, sim->executor, allocator);
         }
+    }
+    STAT_ONLY(stats_end_phase(stats, PHASE_SCHEDULING, &phase_start));
 
-        // increment wait time in input_q for processes that have not been allocated memory yet
-        curr = input_q->head;
-        while(curr) {
-            curr->p->wait_time += quantum;
-            curr = curr->next;
+    for (int c = 0; c < cpu_count; c++) {
+        if (cpus[c].running != NO_PROCESS) {
+            run_cpu(&cpus[c], quantum);
+        } else {
+            STAT_ADD(stats, idle_cycles, 1);
         }
+    }
 
-        simulated_time += quantum;
-        num_cycles++;
+    // processes in ready_q and input_q are charged their wait time when they next run
+
+    simulated_time += quantum;
+    num_cycles++;
+
+    STAT_ONLY(stats_end_phase(stats, PHASE_ACCOUNTING, &phase_start));
+
+    sim->num_cycles = num_cycles;
+    sim->simulated_time = simulated_time;
+    sim->turnaround_time = turnaround_time;
+    sim->num_processes = num_processes;
+    sim->total_overhead = total_overhead;
+    sim->max_overhead = max_overhead;
+
+    if (trace_error(trace)) return fail_simulation(sim, "%s", trace_error(trace));
+    if (sim->executor && executor_error(sim->executor)) {
+        return fail_simulation(sim, "%s", executor_error(sim->executor));
+    }
+    if (out->error) return fail_simulation(sim, "write: %s", strerror(out->error));
+
+    return !trace_is_empty(trace) || !queue_is_empty(input_q) || cpus_are_busy(cpus, cpu_count);
+}
+
+/* Works out the results of a simulation step_simulation has run to the end, and writes them out */
+void finish_simulation(simulation_t *sim) {
+    cpu_t *cpus = sim->cpus;
+    writer_t *out = sim->out;
+    int cpu_count = sim->config.cpus;
+    histogram_t *histograms = sim->histograms;
+    int64_t num_processes = sim->num_processes;
+
+    STAT_ADD(sim->stats, cycles, sim->num_cycles);
 
-    } while (!queue_is_empty(infile_q) || !queue_is_empty(input_q) || !queue_is_empty(ready_q) || running_process);
-    
     // Print performance statistics
-    printf("Turnaround time %.0f\n", ceil((double)turnaround_time/num_processes));
-    printf("Time overhead %.2f %.2f\n", max_overhead, total_overhead/num_processes);
-    printf("Makespan %d\n", simulated_time-quantum);
+    sim->results.turnaround = ceil((double)sim->turnaround_time/num_processes);
+    sim->results.max_overhead = sim->max_overhead;
+    sim->results.average_overhead = sim->total_overhead/num_processes;
+    sim->results.makespan = sim->simulated_time-sim->config.quantum;
+    write_statistics(out, sim->results.turnaround, sim->results.max_overhead,
+        sim->results.average_overhead, sim->results.makespan);
+
+    // per CPU utilisation only makes sense with more than one
+    if (cpu_count > 1) {
+        for (int c = 0; c < cpu_count; c++) {
+            write_cpu_statistics(out, c, cpus[c].busy_time, cpus[c].last_finish, sim->results.makespan);
+        }
+    }
+
+    // distributions behind the means above
+    for (int i = 0; histograms && i < HISTOGRAM_COUNT; i++) {
+        int64_t values[PERCENTILE_COUNT];
+        for (int j = 0; j < PERCENTILE_COUNT; j++) values[j] = histogram_percentile(&histograms[i], percentiles[j]);
+        write_percentiles(out, i, histograms[i].scale, values);
+    }
+
+    if (sim->admission.backfill && sim->allocator) {
+        write_reservation_statistics(out, sim->admission.reservations, sim->admission.reservation_hits,
+            sim->admission.reservation_misses);
+    }
+    if (sim->allocator && allocator_pages(sim->config.memory_strategy)) {
+        allocator_stats_t paging;
+        allocator_stats(sim->allocator, &paging);
+        write_paging_statistics(out, paging.evictions, paging.page_faults, paging.pages_evicted);
+    }
+    if (sim->admission.compact) {
+        write_compaction_statistics(out, sim->admission.compactions, sim->admission.compacted_mb,
+            sim->admission.compaction_stall);
+    }
+
+    // measured, unlike everything above
+    if (sim->executor) {
+        latency_t *dispatch = &sim->executor->dispatch, *context_switch = &sim->executor->context_switch;
+        write_latency_statistics(out, LATENCY_DISPATCH, dispatch->count, dispatch->total_ns, dispatch->max_ns);
+        write_latency_statistics(out, LATENCY_SWITCH, context_switch->count, context_switch->total_ns,
+            context_switch->max_ns);
+    }
 }
 
-/* If best-fit, allocate enough memory to processes */
-void allocate_input_processes(queue_t *input_q, segment_t *memory, queue_t *ready_q, 
-    int strategy, int simulated_time, int quantum) {
-    node_t *curr_q_node = input_q->head;
-    
-    // traverse queue by popping and repushing into queue(s)
-    // and attempt to allocate memory to each
-    // if unavailable memory - repush in input_q
-    // if available memory - push in ready_q
-    while(curr_q_node) {
-        node_t *tmp_node_next = curr_q_node->next;
-        segment_t *curr_segment = memory;
-        segment_t *best_fit_segment = NULL;
-        
-        // Loop through all memory segments
-        while(curr_segment) {
-            // if current segment has no process
-            if (curr_segment->process == NULL) {
-                // if segment can hold process in memory
-                if (segment_available_memory(curr_segment) >= curr_q_node->p->memory_requirement) {
-                    // if no best_fit_segment, curr is best available
-                    if(!best_fit_segment) best_fit_segment = curr_segment;
-                    // get lowest segment sequence number in case on equal size blocks
-                    else {
-                        if (segment_available_memory(best_fit_segment) > segment_available_memory(curr_segment)) {
-                            best_fit_segment = curr_segment;
-                        }
-                    }
-                }
+/* Adds a process to a simulation that has no trace file, in order of arrival and after the last
+   cycle step_simulation ran. Returns -1 if the process comes too late for that */
+int submit_process(simulation_t *sim, const char *name, int64_t time_arrived, int64_t service_time,
+    int64_t memory_requirement) {
+    if (sim->trace == NULL) sim->trace = open_submitted_trace(sim->processes, sim->name_arena);
+    if (sim->num_cycles > 0 && time_arrived <= sim->simulated_time - sim->config.quantum) return -1;
+
+    handle_t p = trace_submit_process(sim->trace, name, strlen(name), time_arrived, service_time,
+        memory_requirement);
+    return p == NO_PROCESS ? -1 : 0;
+}
+
+/* Runs the cycles of a simulation up to time, after which processes arriving later can still be
+   submitted. Returns 0 once every process submitted so far has finished, -1 as step_simulation */
+int advance_simulation(simulation_t *sim, int64_t time) {
+    int running = 1;
+
+    // cycles that can be skipped are only skipped up to time, as later processes are not known yet
+    sim->horizon = time;
+    while (running > 0 && sim->simulated_time <= time) running = step_simulation(sim);
+    sim->horizon = INT64_MAX;
+
+    return running;
+}
+
+/* Process scheduling, runs a simulation to the end, one cycle at a time. Returns -1 with
+   sim->error set if it could not be run to the end */
+int schedule_processes(simulation_t *sim) {
+    int running;
+    while ((running = step_simulation(sim)) > 0);
+    if (running < 0) return -1;
+
+    finish_simulation(sim);
+    return sim->out->error ? fail_simulation(sim, "write: %s", strerror(sim->out->error)) : 0;
+}
+
+/* Puts the next ready process of a CPU's own queue on it, SJF only when the CPU is idle,
+   RR every cycle, switching the running process out to the back of the queue. MLFQ switches
+   when a higher priority process is ready or the running one has used up its time slice */
+void schedule_cpu(cpu_t *cpu, int strategy, int64_t simulated_time, writer_t *out, stats_t *stats,
+    executor_t *executor, allocator_t *allocator) {
+    ready_q_t *ready_q = cpu->ready_q;
+    process_table_t *table = ready_q->table;
+
+    if (strategy == SJF) { // SJF
+        // if no running process and ready_q has process, schedule next ready, under paged memory
+        // once all its pages can be resident
+        if (cpu->running == NO_PROCESS && !ready_is_empty(ready_q)
+            && (!allocator || allocator_can_run(allocator, table, ready_peek_process(ready_q), NO_PROCESS))) {
+            cpu->running = ready_dequeue_process(ready_q);
+            stop_waiting(table, cpu->running, simulated_time);
+            if (executor) executor_run(executor, table, cpu->running, NO_PROCESS);
+            STAT_ADD(stats, context_switches, 1);
+            print_running_process(out, table, simulated_time, cpu->running,
+                process_remaining_time(table, cpu->running), cpu->id);
+            if (allocator) {
+                allocator_run(allocator, table, cpu->running, NO_PROCESS);
+                print_page_events(out, allocator, table, simulated_time, cpu->id);
             }
-            // move on to next memory segment. Best fit searches all segments
-            curr_segment = curr_segment->next_s;
         }
-                
-        // upon successful memory allocation, move to ready queue
-        // Fix input queue, Enqueue process to ready queue, Split memory segment
-
-        // Fixing input queue
-        // Input queue - pop all queue nodes, and reenqueue
-        // If successful allocation, queue current node into ready queue
-        if (best_fit_segment) {
-
-            increment_wait_time(curr_q_node->p, quantum);
-            
-            int times = input_q->count;
-            int i = 0;
-            node_t *curr = input_q->head;
-
-            // dequeue input_q input_q->times times to pop all nodes, if curr is curr_q_node (the node we want)
-            // then push into ready_q depending on Shortest Job First or Round Robin. Otherwise push
-            // back into input_q
-            while(i < times) {
-                node_t *next = curr->next;
-                curr = dequeue_node(input_q);
-
-                // enqueue to ready_q if successful memory allocation
-                if (curr == curr_q_node && best_fit_segment) {
-                    if (strategy == SJF) enqueue_node_sjf(ready_q, curr);
-                    else enqueue_node(ready_q, curr);
-                    curr->p->state = READY;
-                }
-                else {
-                    enqueue_node(input_q, curr);
-                }
-                curr = next;
-                i++;
+    }
+    else { // RR and MLFQ
+        int switch_out = !ready_is_empty(ready_q);
+
+        if (strategy == MLFQ && cpu->running != NO_PROCESS) {
+            mlfq_t *mlfq = ready_q->mlfq;
+            int expired = mlfq_slice_expired(mlfq, cpu->running);
+            if (expired) mlfq_demote(mlfq, cpu->running);
+
+            // a process at the same level takes over only once the slice is used up
+            int top_level = mlfq_top_level(mlfq);
+            int level = table->level[cpu->running];
+            switch_out = top_level < level || (expired && top_level == level);
+        }
+
+        // paged memory keeps the CPU as it is until every page of the next process can be resident
+        handle_t next = switch_out ? ready_peek_process(ready_q) : NO_PROCESS;
+        if (next != NO_PROCESS && allocator && !allocator_can_run(allocator, table, next, cpu->running)) {
+            switch_out = 0;
+        }
+
+        if (switch_out) {
+            // the next process leaves the queue before the running one joins its back
+            handle_t next_process = ready_dequeue_process(ready_q);
+            if (executor) executor_run(executor, table, next_process, cpu->running);
+            handle_t switched_out = cpu->running;
+            // If running process, switch out. There is none at the start of the program
+            // or when there is a gap between processes
+            if (cpu->running != NO_PROCESS) {
+                table->state[cpu->running] = READY;
+                start_waiting(table, cpu->running, simulated_time);
+                ready_enqueue_process(ready_q, cpu->running);
+                STAT_ADD(stats, preemptions, 1);
             }
-        
-            // Split memory segment to accomodate process
-            int remaining_memory = best_fit_segment->mem_end - curr_q_node->p->memory_requirement;
-
-            // assumes process memory req <= best fit segment size
-            if (remaining_memory > 0) {
-                // best_fit_segment reduces its size down to process->memory_requirement, and
-                // next will be inserted into linked list after best_fit_segment
-                segment_t *next = make_new_segment(best_fit_segment->mem_start + curr_q_node->p->memory_requirement, 
-                    best_fit_segment->mem_end);
-                // insertion into doubly linked list
-                best_fit_segment->mem_end = best_fit_segment->mem_start + curr_q_node->p->memory_requirement - 1;
-                next->next_s = best_fit_segment->next_s;
-                next->prev_s = best_fit_segment;
-                if (best_fit_segment->next_s) {
-                    best_fit_segment->next_s->prev_s = next;
-                } 
-                best_fit_segment->next_s = next;
+            cpu->running = next_process;
+            table->state[cpu->running] = RUNNING;
+            stop_waiting(table, cpu->running, simulated_time);
+            STAT_ADD(stats, context_switches, 1);
+            print_running_process(out, table, simulated_time, cpu->running,
+                process_remaining_time(table, cpu->running), cpu->id);
+            if (allocator) {
+                allocator_run(allocator, table, cpu->running, switched_out);
+                print_page_events(out, allocator, table, simulated_time, cpu->id);
             }
-            // assign process to memory segment
-            best_fit_segment->process = curr_q_node->p;
-            print_ready_process(simulated_time, curr_q_node->p->process_name, best_fit_segment->mem_start);
         }
-        
-        // move on to next process in input_q
-        curr_q_node = tmp_node_next;
     }
 }
 
-void print_ready_process(int time, char *name, int mem_index) {
-    printf("%d,READY,process_name=%s,assigned_at=%d\n",
-        time, name, mem_index);
+/* Runs the next process of the longest ready queue on an idle CPU */
+void steal_process(cpu_t *cpus, int cpu_count, cpu_t *thief, int64_t simulated_time, writer_t *out,
+    stats_t *stats, executor_t *executor, allocator_t *allocator) {
+    cpu_t *victim = NULL;
+
+    for (int c = 0; c < cpu_count; c++) {
+        if (ready_is_empty(cpus[c].ready_q)) continue;
+        if (!victim || ready_count(cpus[c].ready_q) > ready_count(victim->ready_q)) victim = &cpus[c];
+    }
+    if (!victim) return;
+
+    // paged memory leaves the CPU idle until every page of the process can be resident
+    process_table_t *table = victim->ready_q->table;
+    if (allocator && !allocator_can_run(allocator, table, ready_peek_process(victim->ready_q), NO_PROCESS)) return;
+
+    thief->running = ready_dequeue_process(victim->ready_q);
+    if (executor) executor_run(executor, table, thief->running, NO_PROCESS);
+    table->state[thief->running] = RUNNING;
+    stop_waiting(table, thief->running, simulated_time);
+    STAT_ADD(stats, context_switches, 1);
+    STAT_ADD(stats, steals, 1);
+    print_running_process(out, table, simulated_time, thief->running,
+        process_remaining_time(table, thief->running), thief->id);
+    if (allocator) {
+        allocator_run(allocator, table, thief->running, NO_PROCESS);
+        print_page_events(out, allocator, table, simulated_time, thief->id);
+    }
+}
+
+/* Runs a CPU's process for a span of time, counting the part of it the process needs as busy */
+void run_cpu(cpu_t *cpu, int64_t time) {
+    process_table_t *table = cpu->ready_q->table;
+    int64_t remaining_time = process_remaining_time(table, cpu->running);
+
+    cpu->busy_time += remaining_time < time ? remaining_time : time;
+    table->time_ran[cpu->running] += time;
+    table->slice_used[cpu->running] += time;
+}
+
+/* MLFQ boost, every running and ready process goes back to level 0 with a fresh slice */
+void boost_cpus(cpu_t *cpus, int cpu_count) {
+    for (int c = 0; c < cpu_count; c++) {
+        mlfq_boost(cpus[c].ready_q->mlfq);
+        if (cpus[c].running != NO_PROCESS) {
+            cpus[c].ready_q->table->level[cpus[c].running] = 0;
+            cpus[c].ready_q->table->slice_used[cpus[c].running] = 0;
+        }
+    }
+}
+
+/* CPU that a newly admitted process is queued on, the one with the fewest processes */
+cpu_t* place_process(cpu_t *cpus, int cpu_count) {
+    cpu_t *best = &cpus[0];
+    int best_load = ready_count(best->ready_q) + (best->running != NO_PROCESS);
+
+    for (int c = 1; c < cpu_count; c++) {
+        int load = ready_count(cpus[c].ready_q) + (cpus[c].running != NO_PROCESS);
+        if (load < best_load) {
+            best = &cpus[c];
+            best_load = load;
+        }
+    }
+
+    return best;
 }
 
-void print_running_process(int time, char *name, int remaining_time) {
-    printf("%d,RUNNING,process_name=%s,remaining_time=%d\n",
-        time, name, remaining_time);
+int total_ready_count(cpu_t *cpus, int cpu_count) {
+    int count = 0;
+    for (int c = 0; c < cpu_count; c++) count += ready_count(cpus[c].ready_q);
+    return count;
 }
 
-void print_finished_process(int time, char* name, int count) {
-    printf("%d,FINISHED,process_name=%s,proc_remaining=%d\n",
-        time, name, count);
+/* Whether any CPU has a process running or ready */
+int cpus_are_busy(cpu_t *cpus, int cpu_count) {
+    for (int c = 0; c < cpu_count; c++) {
+        if (cpus[c].running != NO_PROCESS || !ready_is_empty(cpus[c].ready_q)) return 1;
+    }
+    return 0;
 }
 
-/* Merges two adjacent empty memory holes into one, after a process is terminated */
-void merge_memory_holes(segment_t *memory) {
-    segment_t *curr = memory;
-
-    // Loop through all memory segments
-    while(curr) {
-        // Upon process finish, find the hole the recently finished process was in, or a hole
-        if (!curr->process || (curr->process && curr->process->state == FINISHED)) {
-            curr->process = NULL;
-            segment_t *nexthole = curr->next_s;
-            segment_t *to_free;
-            // Loop through potential next segments that are also holes
-            while(nexthole) {
-                if (nexthole->process && nexthole->process->state != FINISHED) break;
-                // merge nexthole into curr, then free
-                // assert(!nexthole->process);
-                curr->mem_end = nexthole->mem_end;
-                curr->next_s = nexthole->next_s;
-                to_free = nexthole;
-                nexthole = nexthole->next_s;
-                free(to_free);
+/* Returns the first cycle time from simulated_time onwards at which a cycle can change
+   anything: a process arriving, a running process finishing, a RR or MLFQ switch or a steal */
+int64_t next_event_time(trace_t *trace, queue_t *input_q, cpu_t *cpus, int cpu_count,
+    int strategy, int memory_strategy, int64_t simulated_time, int quantum, int64_t next_boost) {
+    process_table_t *table = input_q->table;
+    int queued = 0, idle = 0, boosts_waiting = 0;
+
+    // RR switches processes every cycle while others are ready, MLFQ at once to a higher level,
+    // and processes waiting for infinite memory or for the CPU under SJF are handled in the next cycle
+    for (int c = 0; c < cpu_count; c++) {
+        if (!ready_is_empty(cpus[c].ready_q)) {
+            if (strategy == RR || cpus[c].running == NO_PROCESS) return simulated_time;
+            if (strategy == MLFQ) {
+                mlfq_t *mlfq = cpus[c].ready_q->mlfq;
+                if (mlfq_top_level(mlfq) < table->level[cpus[c].running]) return simulated_time;
+                if (mlfq->bitmap & ~(uint64_t)1) boosts_waiting = 1;
             }
+            queued = 1;
+        }
+        if (cpus[c].running == NO_PROCESS) idle = 1;
+    }
+    // an idle CPU steals from another's queue
+    if (queued && idle) return simulated_time;
+    if (!queue_is_empty(input_q) && memory_strategy == INFINITE) return simulated_time;
+
+    int64_t next_time = INT64_MAX;
+
+    // Cycle in which the first running process is detected as finished
+    for (int c = 0; c < cpu_count; c++) {
+        if (cpus[c].running == NO_PROCESS) continue;
+        int64_t remaining_time = process_remaining_time(table, cpus[c].running);
+        if (remaining_time <= 0) return simulated_time;
+        int64_t finish_cycle = simulated_time + cycles_to_cover(remaining_time, quantum) * quantum;
+        if (finish_cycle < next_time) next_time = finish_cycle;
+
+        // MLFQ switches when the slice runs out with a process of the same level or lower ready.
+        // With none, slices running out only change the level, which is worked out for the cycles
+        // skipped
+        handle_t p = cpus[c].running;
+        if (strategy == MLFQ && !ready_is_empty(cpus[c].ready_q)) {
+            int64_t slice_left = cpus[c].ready_q->mlfq->slices[table->level[p]] - table->slice_used[p];
+            if (slice_left <= 0) return simulated_time;
+            int64_t expiry_cycle = simulated_time + cycles_to_cover(slice_left, quantum) * quantum;
+            if (expiry_cycle < next_time) next_time = expiry_cycle;
         }
-        curr = curr->next_s;
     }
+
+    // MLFQ boost, which only needs a cycle of its own to lift waiting processes. Running ones are
+    // lifted in the cycles skipped
+    if (boosts_waiting) {
+        if (next_boost <= simulated_time) return simulated_time;
+        int64_t boost_cycle = simulated_time + cycles_to_cover(next_boost - simulated_time, quantum) * quantum;
+        if (boost_cycle < next_time) next_time = boost_cycle;
+    }
+
+    // Cycle in which the earliest pending process is submitted
+    if (!trace_is_empty(trace)) {
+        int64_t first_arrival = trace_next_arrival(trace);
+        if (first_arrival <= simulated_time) return simulated_time;
+        int64_t arrival_cycle = simulated_time
+            + cycles_to_cover(first_arrival - simulated_time, quantum) * quantum;
+        if (arrival_cycle < next_time) next_time = arrival_cycle;
+    }
+
+    // Nothing left to wait for, the next cycle runs as it is
+    if (next_time == INT64_MAX) return simulated_time;
+
+    return next_time;
 }
 
-/* For infinite memory, add any nodes from input to ready instantly */
-void add_to_ready_q_infinite(queue_t *input_q, queue_t *ready_q, int strategy, int quantum) {
-    node_t *curr = input_q->head, *next;
+/* Number of quantum-length cycles needed to cover a time span */
+int64_t cycles_to_cover(int64_t time, int quantum) {
+    return (time + quantum - 1) / quantum;
+}
 
-    while(curr) {
-        next = curr->next;
-        node_t *to_enq = dequeue_node(input_q);
-        increment_wait_time(to_enq->p, quantum);
+static int compare_releases(const void *a, const void *b) {
+    int64_t x = ((const release_t *)a)->remaining_time, y = ((const release_t *)b)->remaining_time;
+    return (x > y) - (x < y);
+}
 
-        if (strategy==SJF) enqueue_node_sjf(ready_q, to_enq);
-        else enqueue_node(ready_q, to_enq);
-        to_enq->p->state = READY;
+/* Time from now a process with the remaining time given is expected to finish in, were it one
+   of the admitted ones. The CPUs are taken to be shared evenly, so each process ahead of it by
+   remaining time delays it by that process' remaining time and each behind it by its own */
+static int64_t expected_finish(admission_t *admission, int64_t remaining_time, int cpu_count, int quantum) {
+    uint32_t low = 0, high = admission->release_count;
+    while (low < high) {
+        uint32_t mid = low + (high - low) / 2;
+        if (admission->releases[mid].remaining_time < remaining_time) low = mid + 1;
+        else high = mid;
+    }
 
-        curr = next;
+    int64_t shorter_time = 0;
+    if (low > 0) shorter_time = admission->releases[low - 1].shorter_time + admission->releases[low - 1].remaining_time;
+    int64_t shared_time = shorter_time + (int64_t)(admission->release_count - low + 1) * remaining_time;
+    return cycles_to_cover((shared_time + cpu_count - 1) / cpu_count, quantum) * quantum;
+}
+
+/* Finds the shadow time, when enough memory is expected to be free for the reserved process, and
+   the memory left over then. Every block held is expected back when its process finishes */
+static void expect_releases(admission_t *admission, allocator_t *allocator, process_table_t *table,
+    cpu_t *cpus, int cpu_count, int quantum, int64_t simulated_time) {
+    allocator_stats_t free_memory;
+    allocator_stats(allocator, &free_memory);
+    int64_t available = free_memory.free_mb, needed = table->memory_requirement[admission->reserved];
+
+    if (admission->releases_capacity < table->capacity) {
+        admission->releases = realloc(admission->releases, table->capacity * sizeof(release_t));
+        admission->holders = realloc(admission->holders, table->capacity * sizeof(handle_t));
+        assert(admission->releases!=NULL && admission->holders!=NULL);
+        admission->releases_capacity = table->capacity;
+    }
+
+    // memory is held by the running and ready processes
+    release_t *releases = admission->releases;
+    handle_t *holders = admission->holders;
+    uint32_t count = 0;
+    for (int c = 0; c < cpu_count; c++) {
+        if (cpus[c].running != NO_PROCESS) holders[count++] = cpus[c].running;
+        count += ready_processes(cpus[c].ready_q, holders + count);
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        releases[i].remaining_time = process_remaining_time(table, holders[i]);
+        releases[i].memory_mb = table->memory_requirement[holders[i]];
+    }
+    qsort(releases, count, sizeof(release_t), compare_releases);
+    admission->release_count = count;
+
+    int64_t shorter_time = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        releases[i].shorter_time = shorter_time;
+        shorter_time += releases[i].remaining_time;
+    }
+
+    // the reserved process is left out of the sharing, it only runs once admitted
+    admission->shadow_time = simulated_time;
+    for (uint32_t i = 0; i < count && available < needed; i++) {
+        available += releases[i].memory_mb;
+        int64_t shared_time = releases[i].shorter_time + (int64_t)(count - i) * releases[i].remaining_time;
+        admission->shadow_time = simulated_time
+            + cycles_to_cover((shared_time + cpu_count - 1) / cpu_count, quantum) * quantum;
     }
+    // more than the whole memory, nothing later can delay it
+    if (available < needed) admission->shadow_time = INT64_MAX;
+    admission->extra_mb = available - needed;
 }
 
-/* Adds any ready processes from infile_q to input_q */
-void add_to_input_q(queue_t *infile_q, queue_t *input_q, int simulated_time, int* num_processes) {
-    node_t *curr = infile_q->head;
-    node_t *next;
-
-    while (curr) {
-        next = curr->next;
-        if (curr->p->time_arrived <= simulated_time) {
-            process_t *to_enq = dequeue_process(infile_q);
-            enqueue_process(input_q, to_enq);
-            (*num_processes)++;
+/* Unless memory is infinite, allocate enough memory to processes. Allocation only takes memory,
+   so while none has been freed since the last pass only the processes that arrived after it are
+   tried, and none whose requirement is above the largest hole. With compaction on, a process that
+   only fragmentation keeps out has the memory compacted for it. Returns the MB moved doing so.
+   With backfilling, the first process left waiting reserves memory and later ones are only
+   admitted if they do not delay it */
+int64_t allocate_input_processes(queue_t *input_q, allocator_t *allocator, admission_t *admission,
+    cpu_t *cpus, int cpu_count, int64_t simulated_time, int quantum, writer_t *out, histogram_t *delays) {
+    process_table_t *table = input_q->table;
+    handle_t prev = NO_PROCESS, curr_q_process = input_q->head;
+    // memory compacted during the pass has every process retried in the next
+    uint64_t generation = allocator->generation;
+    int64_t compacted_mb = 0;
+    int expected = 0;           // shadow time worked out this pass
+
+    if (allocator->generation == admission->generation && admission->tried_foot != NO_PROCESS) {
+        prev = admission->tried_foot;
+        curr_q_process = table->next[prev];
+        STAT_ADD(allocator->stats, skipped_admissions, admission->tried_count);
+    }
+    int64_t largest = curr_q_process != NO_PROCESS ? allocator_largest_hole(allocator) : 0;
+
+    // walk the input queue in order, moving each process memory is found for to a ready queue
+    while(curr_q_process != NO_PROCESS) {
+        handle_t tmp_process_next = table->next[curr_q_process];
+
+        // block chosen by the memory strategy, -1 if none fits
+        int64_t mem_start = -1;
+        int64_t memory_requirement = table->memory_requirement[curr_q_process];
+
+        // a process behind the reserved one may not hold memory the reservation counts on, only
+        // worked out for those memory could be found for
+        int backfilled = 1, uses_extra = 0;
+        if (admission->reserved != NO_PROCESS && curr_q_process != admission->reserved
+            && (memory_requirement <= largest || admission->compact)) {
+            if (!expected) {
+                expect_releases(admission, allocator, table, cpus, cpu_count, quantum, simulated_time);
+                expected = 1;
+            }
+            int64_t finish = simulated_time + expected_finish(admission,
+                process_remaining_time(table, curr_q_process), cpu_count, quantum);
+            if (finish > admission->shadow_time) {
+                uses_extra = 1;
+                backfilled = memory_requirement <= admission->extra_mb;
+            }
+        }
+
+        if (!backfilled) STAT_ADD(allocator->stats, backfill_refusals, 1);
+        else if (memory_requirement > largest && admission->compact) {
+            // only fragmentation keeps the process out, slide the blocks together
+            allocator_stats_t free_memory;
+            allocator_stats(allocator, &free_memory);
+            if (memory_requirement <= free_memory.free_mb) {
+                int64_t moved_mb = allocator_compact(allocator, table);
+                admission->compactions++;
+                admission->compacted_mb += moved_mb;
+                compacted_mb += moved_mb;
+                write_compaction(out, simulated_time, moved_mb);
+                largest = allocator_largest_hole(allocator);
+            }
         }
-        curr = next;
+        if (backfilled && memory_requirement <= largest) {
+            mem_start = allocator_allocate(allocator, table, curr_q_process);
+        }
+        else if (backfilled) STAT_ADD(allocator->stats, skipped_admissions, 1);
+
+        // upon successful memory allocation, unlink from input queue and enqueue to a ready queue
+        if (mem_start >= 0) {
+            increment_wait_time(table, curr_q_process, quantum);
+            cpu_t *cpu = place_process(cpus, cpu_count);
+
+            queue_remove_after(input_q, prev, curr_q_process);
+            ready_enqueue_process(cpu->ready_q, curr_q_process);
+            table->state[curr_q_process] = READY;
+
+            print_page_events(out, allocator, table, simulated_time, cpu->id);
+            print_ready_process(out, table, simulated_time, curr_q_process, mem_start, cpu->id);
+            if (delays) histogram_record(delays, simulated_time - table->time_arrived[curr_q_process]);
+            largest = allocator_largest_hole(allocator);
+
+            if (uses_extra) admission->extra_mb -= memory_requirement;
+            if (curr_q_process == admission->reserved) {
+                if (simulated_time <= admission->reservation_time) admission->reservation_hits++;
+                else admission->reservation_misses++;
+                admission->reserved = NO_PROCESS;
+            }
+        } else {
+            if (backfilled && admission->backfill && admission->reserved == NO_PROCESS) {
+                admission->reserved = curr_q_process;
+                admission->reservations++;
+                expect_releases(admission, allocator, table, cpus, cpu_count, quantum, simulated_time);
+                admission->reservation_time = admission->shadow_time;
+                expected = 1;
+            }
+            prev = curr_q_process;
+        }
+
+        // move on to next process in input_q
+        curr_q_process = tmp_process_next;
     }
 
+    admission->generation = generation;
+    admission->tried_foot = input_q->foot;
+    admission->tried_count = input_q->count;
+
+    return compacted_mb;
+}
+
+void print_ready_process(writer_t *out, process_table_t *table, int64_t time, handle_t p, int64_t mem_index,
+    int cpu) {
+    write_process_event(out, EVENT_READY, time, table->id[p], process_name(table, p), table->name_length[p],
+        mem_index, cpu);
 }
 
-/* Creates a new memory segment to fit a process into */
-segment_t *make_new_segment(int from, int to) {
-    segment_t *s = malloc(sizeof(segment_t));
-    assert(s!=NULL);
+void print_running_process(writer_t *out, process_table_t *table, int64_t time, handle_t p,
+    int64_t remaining_time, int cpu) {
+    write_process_event(out, EVENT_RUNNING, time, table->id[p], process_name(table, p), table->name_length[p],
+        remaining_time, cpu);
+}
 
-    s->mem_start = from;
-    s->mem_end = to;
-    s->process = NULL;
-    s->next_s = NULL;
-    s->prev_s = NULL;
+/* Pages evicted to make room for a process and faulted in as it runs, under paged and virtual memory */
+void print_page_events(writer_t *out, allocator_t *allocator, process_table_t *table, int64_t time, int cpu) {
+    const page_event_t *events;
+    uint32_t count = allocator_page_events(allocator, &events);
 
-    return s;
+    for (uint32_t i = 0; i < count; i++) {
+        handle_t p = events[i].p;
+        write_process_event(out, events[i].type == PAGE_EVICTED ? EVENT_EVICTED : EVENT_FAULTED, time, table->id[p],
+            process_name(table, p), table->name_length[p], events[i].pages, cpu);
+    }
 }
 
-int segment_available_memory(segment_t *curr) {
-    return curr->mem_end - curr->mem_start + 1;
+void print_finished_process(writer_t *out, process_table_t *table, int64_t time, handle_t p, int count,
+    int cpu) {
+    write_process_event(out, EVENT_FINISHED, time, table->id[p], process_name(table, p), table->name_length[p],
+        count, cpu);
 }
 
-/* Creates an empty memory hole from 0 to 2048 */
-segment_t* initialize_simulated_memory(int memory_strategy) {
-    segment_t *s = malloc(sizeof(segment_t));
-    assert(s!=NULL);
-    s->prev_s = NULL;
-    s->next_s = NULL;
+/* For infinite memory, add any processes from input to ready instantly */
+void add_to_ready_q_infinite(queue_t *input_q, cpu_t *cpus, int cpu_count, int64_t simulated_time, int quantum,
+    histogram_t *delays) {
+    process_table_t *table = input_q->table;
+
+    while(!queue_is_empty(input_q)) {
+        handle_t to_enq = dequeue_process(input_q);
+        increment_wait_time(table, to_enq, quantum);
+        if (delays) histogram_record(delays, simulated_time - table->time_arrived[to_enq]);
+
+        ready_enqueue_process(place_process(cpus, cpu_count)->ready_q, to_enq);
+        table->state[to_enq] = READY;
+    }
+}
 
-    s->mem_start = 0;
-    s->mem_end = MEMORY_MB;
-    
-    s->process = NULL;
+/* Adds any processes that have arrived by simulated_time from the trace to input_q. Returns one
+   that needs more than capacity_mb and so could never be admitted, NO_PROCESS if none does */
+handle_t add_to_input_q(trace_t *trace, queue_t *input_q, int64_t simulated_time, int quantum,
+    int64_t capacity_mb, int64_t *num_processes, writer_t *out) {
+    handle_t too_large = NO_PROCESS;
+
+    while (trace_next_arrival(trace) <= simulated_time) {
+        process_table_t *table = trace->processes;
+        handle_t to_enq = trace_next_process(trace);
+        // a process read late from an unsorted trace still waits from the cycle it arrived in
+        start_waiting(table, to_enq, cycles_to_cover(table->time_arrived[to_enq], quantum) * quantum);
+        write_process_name(out, simulated_time, table->id[to_enq], process_name(table, to_enq),
+            table->name_length[to_enq]);
+        enqueue_process(input_q, to_enq);
+        (*num_processes)++;
+        if (too_large == NO_PROCESS && table->memory_requirement[to_enq] > capacity_mb) too_large = to_enq;
+    }
 
-    return s;
-}
\ No newline at end of file
+    return too_large;
+}
@@ -9,45 +9,167 @@
 #include<assert.h>
 #include<limits.h>
 #include<math.h>
+#include<stdarg.h>
 #include"queues.h"
+#include"ready.h"
+#include"allocator.h"
+#include"trace.h"
+#include"output.h"
+#include"stats.h"
+#include"executor.h"
+#include"histogram.h"
 
-#define SJF 0
-#define RR 1
-#define INFINITE 0
-#define BESTFIT 1
+#define MAX_CPUS 65536     // CPU ids are 16 bits in the binary event log
+#define TICK 0
+#define EVENT 1
+#define GREEDY 0
+#define BACKFILL 1
+#define SIMULATION_ERROR_BYTES 256
 
-#define MEMORY_MB 2048
+typedef struct {
+    int strategy;
+    int memory_strategy;
+    int quantum;
+    int time_advance;
+    int64_t memory_mb;
+    int64_t granularity;        // bytes, memory is allocated in multiples of it
+    int cpus;
+    int compaction;             // compact memory when fragmentation keeps a process out
+    double compaction_cost;     // time per MB moved
+    int admission;              // GREEDY admits any process that fits, BACKFILL keeps a reservation
+    int histograms;             // record the distributions behind the percentiles
 
-typedef struct segment segment_t;
+    // MLFQ, 0 for the defaults
+    int mlfq_levels;
+    int64_t mlfq_slices[MLFQ_MAX_LEVELS];   // time slice of each level, doubling from the quantum
+    int64_t mlfq_boost;                 // time between boosts of every process to level 0
+} config_t;
 
-// doubly linked list
-struct segment {
-    int mem_start;
-    int mem_end;
-    segment_t *next_s;
-    segment_t *prev_s;
-    process_t *process;
-};
+// one simulated CPU with its own ready queue
+typedef struct {
+    int id;
+    handle_t running;           // NO_PROCESS while idle
+    ready_q_t *ready_q;
+    int64_t busy_time;          // time its processes actually needed of the cycles they ran
+    int64_t last_finish;        // its own makespan
+} cpu_t;
 
+// a memory block expected to be freed when its process finishes
+typedef struct {
+    int64_t remaining_time;     // of its process
+    int64_t shorter_time;       // remaining of the processes ahead of it by remaining time
+    int64_t memory_mb;
+} release_t;
 
-void print_ready_process(int time, char *name, int mem_index);
-void print_running_process(int time, char *name, int remaining_time);
-void print_finished_process(int time, char* name, int count);
+// what the last admission pass saw, a process it could not fit is only retried once memory is freed
+typedef struct {
+    uint64_t generation;        // of the allocator when the pass ran
+    handle_t tried_foot;        // input_q's foot after the pass, processes behind it are untried
+    int tried_count;            // processes it left waiting
 
-// Memory
-void merge_memory_holes(segment_t *memory);
-segment_t *make_new_segment(int from, int to);
-segment_t* initialize_simulated_memory(int memory_strategy);
-int segment_available_memory(segment_t *curr);
+    // opt-in compaction, the blocks are slid together when only fragmentation keeps a process out
+    int compact;
+    int64_t compactions;
+    int64_t compacted_mb;       // moved by them
+    int64_t compaction_stall;   // simulated time charged for moving it
+
+    // EASY backfilling, the first process no memory is found for is promised the time enough
+    // memory is expected to be free for it, and later processes only go ahead if they end before
+    // then or fit in what it leaves over
+    int backfill;
+    handle_t reserved;          // NO_PROCESS while no process holds a reservation
+    int64_t reservation_time;   // as promised when it was made
+    int64_t shadow_time;        // as now expected
+    int64_t extra_mb;           // free at the shadow time beyond the reserved process' requirement
+    int64_t reservations;
+    int64_t reservation_hits;   // the reserved process was admitted by its reservation time
+    int64_t reservation_misses;
+    release_t *releases;        // blocks held, by remaining time of their processes
+    handle_t *holders;          // scratch, the processes holding them
+    uint32_t release_count;
+    uint32_t releases_capacity;
+} admission_t;
+
+// performance statistics of a finished run, as printed at the end of it
+typedef struct {
+    double turnaround;
+    double max_overhead;
+    double average_overhead;
+    int64_t makespan;
+} results_t;
+
+// all state of one simulation run, independent runs share nothing
+typedef struct {
+    config_t config;
+    trace_t *trace;
+    queue_t *input_q;
+    cpu_t *cpus;                // config.cpus of them
+    int64_t next_boost;         // time of the next MLFQ boost
+    allocator_t *allocator;     // NULL for infinite memory
+    admission_t admission;
+    writer_t *out;
+
+    process_table_t *processes;
+    arena_t *name_arena;
+
+    // progress of the run, up to date between steps
+    int64_t simulated_time;
+    int64_t num_cycles;
+    int64_t turnaround_time;
+    int64_t num_processes;
+    double total_overhead;
+    double max_overhead;
+    int64_t horizon;            // cycles are not skipped past it, processes may still arrive after it
+
+    const char *checkpoint_file;    // written once simulated time reaches checkpoint_at
+    int64_t checkpoint_at;
+
+    results_t results;
+    histogram_t *histograms;    // HISTOGRAM_COUNT of them, NULL unless recorded
+    stats_t *stats;             // NULL unless built with STATS=1
+    executor_t *executor;       // NULL unless processes really run, -x
+
+    char error[SIMULATION_ERROR_BYTES];    // why step_simulation failed, empty until it does
+} simulation_t;
+
+void print_ready_process(writer_t *out, process_table_t *table, int64_t time, handle_t p, int64_t mem_index,
+     int cpu);
+void print_running_process(writer_t *out, process_table_t *table, int64_t time, handle_t p,
+     int64_t remaining_time, int cpu);
+void print_finished_process(writer_t *out, process_table_t *table, int64_t time, handle_t p, int count, int cpu);
+void print_page_events(writer_t *out, allocator_t *allocator, process_table_t *table, int64_t time, int cpu);
 
 // Process scheduling
-void allocate_input_processes(queue_t *input_q, segment_t *memory, queue_t *ready_q, int strategy, int simulated_time, int quantum);
-segment_t* initialize_simulated_memory(int memory_strategy);
-void schedule_processes(queue_t *infile_q, queue_t *input_q,
-     queue_t *ready_q, int strategy, int quantum, segment_t *memory, int memory_strategy);
-void add_to_ready_q_infinite(queue_t *input_q, queue_t *ready_q, int strategy, int quantum);
-void add_to_input_q(queue_t *infile_q, queue_t *input_q,
-     int simulated_time, int* num_processes);
+int64_t allocate_input_processes(queue_t *input_q, allocator_t *allocator, admission_t *admission,
+     cpu_t *cpus, int cpu_count, int64_t simulated_time, int quantum, writer_t *out, histogram_t *delays);
+simulation_t* make_simulation(config_t *config, writer_t *out);
+void free_simulation(simulation_t *sim);
+int schedule_processes(simulation_t *sim);
+int submit_process(simulation_t *sim, const char *name, int64_t time_arrived, int64_t service_time,
+     int64_t memory_requirement);
+int step_simulation(simulation_t *sim);
+int advance_simulation(simulation_t *sim, int64_t time);
+void finish_simulation(simulation_t *sim);
+void add_to_ready_q_infinite(queue_t *input_q, cpu_t *cpus, int cpu_count, int64_t simulated_time, int quantum,
+     histogram_t *delays);
+handle_t add_to_input_q(trace_t *trace, queue_t *input_q, int64_t simulated_time, int quantum,
+     int64_t capacity_mb, int64_t *num_processes, writer_t *out);
+
+// CPUs
+void schedule_cpu(cpu_t *cpu, int strategy, int64_t simulated_time, writer_t *out, stats_t *stats,
+     executor_t *executor, allocator_t *allocator);
+void steal_process(cpu_t *cpus, int cpu_count, cpu_t *thief, int64_t simulated_time, writer_t *out,
+     stats_t *stats, executor_t *executor, allocator_t *allocator);
+void run_cpu(cpu_t *cpu, int64_t time);
+void boost_cpus(cpu_t *cpus, int cpu_count);
+cpu_t* place_process(cpu_t *cpus, int cpu_count);
+int total_ready_count(cpu_t *cpus, int cpu_count);
+int cpus_are_busy(cpu_t *cpus, int cpu_count);
+
+// Event-driven time advance
+int64_t next_event_time(trace_t *trace, queue_t *input_q, cpu_t *cpus, int cpu_count,
+     int strategy, int memory_strategy, int64_t simulated_time, int quantum, int64_t next_boost);
+int64_t cycles_to_cover(int64_t time, int quantum);
 
 
-#endif
\ No newline at end of file
+#endif
\ No newline at end of file
@@ -0,0 +1,325 @@
+#include"allocator.h"
+
+/* Best, first, next and worst fit share the segment list in memory.c and differ only in
+   which hole they pick */
+
+static void* list_make(int64_t memory_units, stats_t *stats) {
+    return initialize_simulated_memory(memory_units, stats);
+}
+
+static void list_free(void *state) {
+    free_simulated_memory(state);
+}
+
+static int64_t list_assign(memory_t *memory, segment_t *hole, process_table_t *table, handle_t p, int64_t units) {
+    if (!hole) return -1;
+    assign_hole(memory, hole, units, p);
+    table->segment[p] = hole->index;
+    return hole->mem_start;
+}
+
+static int64_t best_fit_allocate(void *state, process_table_t *table, handle_t p, int64_t units) {
+    return list_assign(state, find_best_fit_hole(state, units), table, p, units);
+}
+
+static int64_t first_fit_allocate(void *state, process_table_t *table, handle_t p, int64_t units) {
+    return list_assign(state, find_first_fit_hole(state, units), table, p, units);
+}
+
+static int64_t next_fit_allocate(void *state, process_table_t *table, handle_t p, int64_t units) {
+    return list_assign(state, find_next_fit_hole(state, units), table, p, units);
+}
+
+static int64_t worst_fit_allocate(void *state, process_table_t *table, handle_t p, int64_t units) {
+    return list_assign(state, find_worst_fit_hole(state, units), table, p, units);
+}
+
+static void list_release(void *state, process_table_t *table, handle_t p, int64_t start, int64_t units) {
+    free_segment(state, memory_segment(state, table->segment[p]));
+    table->segment[p] = NO_SEGMENT;
+}
+
+static void list_stats(void *state, allocator_stats_t *out) {
+    memory_t *memory = state;
+    out->holes = memory->hole_count;
+    out->free_mb = memory->hole_memory;
+    out->largest_hole = largest_hole(memory);
+}
+
+static size_t list_checkpoint(void *state, void *buffer) {
+    return checkpoint_memory(state, buffer);
+}
+
+static int list_restore(void *state, process_table_t *table, const void *data, size_t length) {
+    return restore_memory(state, table, data, length);
+}
+
+/* Slides the blocks together, the processes moved get their new starts in MB */
+static int64_t list_compact(void *state, process_table_t *table, int unit_shift) {
+    memory_t *memory = state;
+    int64_t moved = compact_memory(memory);
+
+    for (segment_t *s = memory->head; s; s = s->next_s) {
+        if (s->process != NO_PROCESS) table->mem_start[s->process] = (s->mem_start << unit_shift) >> 20;
+    }
+    return moved;
+}
+
+static void* buddy_make(int64_t memory_units, stats_t *stats) {
+    return make_buddy(memory_units, stats);
+}
+
+static void buddy_free(void *state) {
+    free_buddy(state);
+}
+
+static int64_t buddy_allocate_process(void *state, process_table_t *table, handle_t p, int64_t units) {
+    return buddy_allocate(state, units);
+}
+
+static void buddy_release(void *state, process_table_t *table, handle_t p, int64_t start, int64_t units) {
+    buddy_free_block(state, start, units);
+}
+
+static void buddy_stats_wrapper(void *state, allocator_stats_t *out) {
+    buddy_stats(state, &out->holes, &out->free_mb, &out->largest_hole);
+}
+
+static size_t buddy_checkpoint(void *state, void *buffer) {
+    return checkpoint_buddy(state, buffer);
+}
+
+static int buddy_restore(void *state, process_table_t *table, const void *data, size_t length) {
+    return restore_buddy(state, data, length);
+}
+
+/* Paged and virtual memory share the pager in paging.c, and differ in how much of a process
+   has to be resident */
+
+static void* paged_make(int64_t memory_units, stats_t *stats) {
+    return make_pager(memory_units, 0, stats);
+}
+
+static void* virtual_make(int64_t memory_units, stats_t *stats) {
+    return make_pager(memory_units, 1, stats);
+}
+
+static void pager_free(void *state) {
+    free_pager(state);
+}
+
+static int64_t pager_allocate_process(void *state, process_table_t *table, handle_t p, int64_t units) {
+    return pager_allocate(state, table, p, units);
+}
+
+static void pager_release_process(void *state, process_table_t *table, handle_t p, int64_t start, int64_t units) {
+    pager_release(state, p);
+}
+
+static void pager_stats(void *state, allocator_stats_t *out) {
+    pager_t *pager = state;
+    out->holes = pager->free_frames > 0;
+    out->free_mb = pager->free_frames;
+    out->largest_hole = pager_admittable(pager);
+    out->page_faults = pager->page_faults;
+    out->evictions = pager->evictions;
+    out->pages_evicted = pager->pages_evicted;
+}
+
+// paged and virtual memory are of different state families, and restore_pager checks the saved mode
+static size_t pager_checkpoint(void *state, void *buffer) {
+    return checkpoint_pager(state, buffer);
+}
+
+static int pager_restore(void *state, process_table_t *table, const void *data, size_t length) {
+    return restore_pager(state, table, data, length);
+}
+
+static void pager_run_process(void *state, process_table_t *table, handle_t p, handle_t switched_out) {
+    pager_run(state, table, p, switched_out);
+}
+
+static uint32_t pager_page_events(void *state, const page_event_t **events) {
+    return pager_events(state, events);
+}
+
+// virtual memory runs a process with whatever of it is resident, and needs no check
+static int paged_can_run(void *state, process_table_t *table, handle_t p, handle_t switched_out) {
+    return pager_can_run(state, table, p, switched_out);
+}
+
+static const allocator_ops_t allocators[MEMORY_STRATEGY_COUNT] = {
+    [INFINITE] = { "infinite", NO_STATE, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL },
+    [BESTFIT] = { "best-fit", SEGMENT_LIST_STATE, list_make, list_free, best_fit_allocate, list_release, list_stats,
+        list_checkpoint, list_restore, list_compact },
+    [FIRSTFIT] = { "first-fit", SEGMENT_LIST_STATE, list_make, list_free, first_fit_allocate, list_release, list_stats,
+        list_checkpoint, list_restore, list_compact },
+    [NEXTFIT] = { "next-fit", SEGMENT_LIST_STATE, list_make, list_free, next_fit_allocate, list_release, list_stats,
+        list_checkpoint, list_restore, list_compact },
+    [WORSTFIT] = { "worst-fit", SEGMENT_LIST_STATE, list_make, list_free, worst_fit_allocate, list_release, list_stats,
+        list_checkpoint, list_restore, list_compact },
+    [BUDDY] = { "buddy", BUDDY_STATE, buddy_make, buddy_free, buddy_allocate_process, buddy_release, buddy_stats_wrapper,
+        buddy_checkpoint, buddy_restore, NULL },
+    [PAGED] = { "paged", PAGED_STATE, paged_make, pager_free, pager_allocate_process, pager_release_process, pager_stats,
+        pager_checkpoint, pager_restore, NULL, pager_run_process, pager_page_events, paged_can_run, PAGE_SHIFT },
+    [VIRTUAL] = { "virtual", VIRTUAL_STATE, virtual_make, pager_free, pager_allocate_process, pager_release_process, pager_stats,
+        pager_checkpoint, pager_restore, NULL, pager_run_process, pager_page_events, NULL, PAGE_SHIFT },
+};
+
+/* Memory strategy named on the command line, -1 if there is none by that name */
+int parse_memory_strategy(const char *name) {
+    for (int i = 0; i < MEMORY_STRATEGY_COUNT; i++) {
+        if (strcmp(allocators[i].name, name) == 0) return i;
+    }
+    return -1;
+}
+
+const char* memory_strategy_name(int memory_strategy) {
+    return allocators[memory_strategy].name;
+}
+
+/* Parses a memory size such as 512, 64G or 4K into bytes, a plain number is in MB.
+   Returns 0 if the size is malformed or above MAX_MEMORY_MB */
+int64_t parse_memory_size(const char *size) {
+    char *end;
+    long long value = strtoll(size, &end, 10);
+    int shift;
+
+    switch (*end) {
+        case '\0': case 'M': case 'm': shift = 20; break;
+        case 'K': case 'k': shift = 10; break;
+        case 'G': case 'g': shift = 30; break;
+        case 'T': case 't': shift = 40; break;
+        default: return 0;
+    }
+    if (end == size || value <= 0 || (*end && end[1] && strcmp(end + 1, "B") && strcmp(end + 1, "iB"))) return 0;
+    if (value > (MAX_MEMORY_MB << 20) >> shift) return 0;
+
+    return (int64_t)value << shift;
+}
+
+/* Creates the allocator of a memory strategy, NULL for infinite memory */
+allocator_t* make_allocator(int memory_strategy, int64_t memory_mb, int64_t granularity, stats_t *stats) {
+    if (memory_strategy == INFINITE) return NULL;
+
+    allocator_t *allocator = malloc(sizeof(allocator_t));
+    assert(allocator!=NULL);
+    allocator->ops = &allocators[memory_strategy];
+    allocator->unit_shift = allocator->ops->unit_shift ? allocator->ops->unit_shift : __builtin_ctzll(granularity);
+    allocator->state = allocator->ops->make((memory_mb << 20) >> allocator->unit_shift, stats);
+    allocator->stats = stats;
+    allocator->generation = 0;
+    allocator->capacity_mb = allocator_largest_hole(allocator);
+
+    return allocator;
+}
+
+void free_allocator(allocator_t *allocator) {
+    allocator->ops->free(allocator->state);
+    free(allocator);
+}
+
+/* Units of the granularity that hold a requirement in MB, rounded up */
+static int64_t to_units(allocator_t *allocator, int64_t mb) {
+    int64_t granularity = (int64_t)1 << allocator->unit_shift;
+    return ((mb << 20) + granularity - 1) >> allocator->unit_shift;
+}
+
+/* MB in a number of units, blocks only ever start on a whole MB */
+static int64_t to_mb(allocator_t *allocator, int64_t units) {
+    return (units << allocator->unit_shift) >> 20;
+}
+
+/* Gives p a block of memory, returns its start in MB or -1 if no block is free */
+int64_t allocator_allocate(allocator_t *allocator, process_table_t *table, handle_t p) {
+    int64_t mem_start = -1;
+    if (table->memory_requirement[p] <= MAX_MEMORY_MB) {
+        mem_start = allocator->ops->allocate(allocator->state, table, p,
+            to_units(allocator, table->memory_requirement[p]));
+    }
+    if (mem_start < 0) {
+        STAT_ADD(allocator->stats, failed_admissions, 1);
+        return -1;
+    }
+    table->mem_start[p] = to_mb(allocator, mem_start);
+    return table->mem_start[p];
+}
+
+void allocator_release(allocator_t *allocator, process_table_t *table, handle_t p) {
+    allocator->ops->release(allocator->state, table, p, to_units(allocator, table->mem_start[p]),
+        to_units(allocator, table->memory_requirement[p]));
+    table->mem_start[p] = -1;
+    allocator->generation++;
+}
+
+/* Free memory in MB */
+void allocator_stats(allocator_t *allocator, allocator_stats_t *out) {
+    memset(out, 0, sizeof(allocator_stats_t));
+    allocator->ops->stats(allocator->state, out);
+    out->free_mb = to_mb(allocator, out->free_mb);
+    out->largest_hole = to_mb(allocator, out->largest_hole);
+}
+
+/* Size in MB of the largest free block, no requirement above it can be allocated */
+int64_t allocator_largest_hole(allocator_t *allocator) {
+    allocator_stats_t free_memory;
+    allocator_stats(allocator, &free_memory);
+    return free_memory.largest_hole;
+}
+
+/* Saves the allocator's state into buffer, returns the bytes it takes. A NULL buffer only sizes it */
+size_t allocator_checkpoint(allocator_t *allocator, void *buffer) {
+    return allocator->ops->checkpoint(allocator->state, buffer);
+}
+
+/* Replaces the allocator's state with a saved one, returns -1 if the saved state is not one this
+   allocator could have had */
+int allocator_restore(allocator_t *allocator, process_table_t *table, const void *data, size_t length) {
+    if (allocator->ops->restore(allocator->state, table, data, length) != 0) return -1;
+    allocator->generation++;
+    return 0;
+}
+
+/* Whether memory saved under one strategy can be restored under another, the segment list
+   strategies share their state and only differ in which hole they pick next */
+int allocators_share_state(int memory_strategy, int other) {
+    return allocators[memory_strategy].state_family == allocators[other].state_family;
+}
+
+/* Whether a memory strategy's blocks can be slid together, buddy blocks have to stay aligned */
+int allocator_can_compact(int memory_strategy) {
+    return allocators[memory_strategy].compact != NULL;
+}
+
+/* Coalesces all free memory into one hole, returns the MB moved */
+int64_t allocator_compact(allocator_t *allocator, process_table_t *table) {
+    int64_t moved = allocator->ops->compact(allocator->state, table, allocator->unit_shift);
+    allocator->generation++;
+    return to_mb(allocator, moved);
+}
+
+/* Whether a memory strategy pages, so processes have to be told to it as they run */
+int allocator_pages(int memory_strategy) {
+    return allocators[memory_strategy].run != NULL;
+}
+
+/* A process was put on a CPU, in place of switched_out if that is not NO_PROCESS. The pages of
+   the process switched out can be evicted again, so a process that did not fit may now */
+void allocator_run(allocator_t *allocator, process_table_t *table, handle_t p, handle_t switched_out) {
+    if (!allocator->ops->run) return;
+    allocator->ops->run(allocator->state, table, p, switched_out);
+    if (switched_out != NO_PROCESS) allocator->generation++;
+}
+
+/* Whether p can be put on a CPU now in place of switched_out, which may be NO_PROCESS. Paged
+   memory has to be able to make every page of p resident */
+int allocator_can_run(allocator_t *allocator, process_table_t *table, handle_t p, handle_t switched_out) {
+    if (!allocator->ops->can_run) return 1;
+    return allocator->ops->can_run(allocator->state, table, p, switched_out);
+}
+
+/* Pages evicted and faulted in since it was last called, reported by the caller */
+uint32_t allocator_page_events(allocator_t *allocator, const page_event_t **events) {
+    if (!allocator->ops->page_events) return 0;
+    return allocator->ops->page_events(allocator->state, events);
+}
@@ -0,0 +1,97 @@
+#ifndef _ALLOCATOR_H_
+#define _ALLOCATOR_H_
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<assert.h>
+#include"queues.h"
+#include"memory.h"
+#include"buddy.h"
+#include"paging.h"
+#include"stats.h"
+
+// memory strategies selected with -m, infinite memory admits every process without an allocator
+#define INFINITE 0
+#define BESTFIT 1
+#define FIRSTFIT 2
+#define NEXTFIT 3
+#define WORSTFIT 4
+#define BUDDY 5
+#define PAGED 6
+#define VIRTUAL 7
+#define MEMORY_STRATEGY_COUNT 8
+
+// what an allocator's state holds, a checkpoint can be restored under any strategy of its family
+#define NO_STATE 0
+#define SEGMENT_LIST_STATE 1
+#define BUDDY_STATE 2
+#define PAGED_STATE 3
+#define VIRTUAL_STATE 4
+
+// memory is handed out in units of the granularity, a power of two from 4 KiB up
+#define MEMORY_GRANULARITY ((int64_t)1 << 20)
+#define MIN_GRANULARITY ((int64_t)4 << 10)
+#define MAX_MEMORY_MB ((int64_t)1 << 40)
+
+// free memory as seen by an allocator, in MB
+typedef struct {
+    int holes;
+    int64_t free_mb;
+    int64_t largest_hole;       // no larger requirement can be allocated
+
+    // paged and virtual memory only
+    int64_t page_faults;
+    int64_t evictions;
+    int64_t pages_evicted;
+} allocator_stats_t;
+
+// one memory allocation policy, state is whatever the backend's make returns. Backends work in
+// allocation units, sizes and starts are converted to and from MB by the allocator
+typedef struct {
+    const char *name;
+    int state_family;
+    void* (*make)(int64_t memory_units, stats_t *stats);
+    void (*free)(void *state);
+    int64_t (*allocate)(void *state, process_table_t *table, handle_t p, int64_t units);    // start, -1 if none fits
+    void (*release)(void *state, process_table_t *table, handle_t p, int64_t start, int64_t units);
+    void (*stats)(void *state, allocator_stats_t *out);                 // in units
+    size_t (*checkpoint)(void *state, void *buffer);   // bytes saved, only sizes them if buffer is NULL
+    int (*restore)(void *state, process_table_t *table, const void *data, size_t length);    // -1 if it does not fit
+    int64_t (*compact)(void *state, process_table_t *table, int unit_shift);   // units moved, NULL if blocks stay put
+    void (*run)(void *state, process_table_t *table, handle_t p, handle_t switched_out);    // NULL unless paging
+    uint32_t (*page_events)(void *state, const page_event_t **events);
+    int (*can_run)(void *state, process_table_t *table, handle_t p, handle_t switched_out);    // NULL if any can
+    int unit_shift;             // fixed allocation unit, 0 to use the granularity
+} allocator_ops_t;
+
+typedef struct {
+    const allocator_ops_t *ops;
+    void *state;
+    stats_t *stats;
+    int unit_shift;             // log2 of the granularity in bytes
+    uint64_t generation;        // bumped whenever memory is freed, a failed fit can only succeed after it
+    int64_t capacity_mb;        // the largest requirement that fits in empty memory
+} allocator_t;
+
+int parse_memory_strategy(const char *name);
+const char* memory_strategy_name(int memory_strategy);
+int64_t parse_memory_size(const char *size);
+
+allocator_t* make_allocator(int memory_strategy, int64_t memory_mb, int64_t granularity, stats_t *stats);
+void free_allocator(allocator_t *allocator);
+int64_t allocator_allocate(allocator_t *allocator, process_table_t *table, handle_t p);
+void allocator_release(allocator_t *allocator, process_table_t *table, handle_t p);
+void allocator_stats(allocator_t *allocator, allocator_stats_t *out);
+int64_t allocator_largest_hole(allocator_t *allocator);
+size_t allocator_checkpoint(allocator_t *allocator, void *buffer);
+int allocator_restore(allocator_t *allocator, process_table_t *table, const void *data, size_t length);
+int allocators_share_state(int memory_strategy, int other);
+int allocator_can_compact(int memory_strategy);
+int64_t allocator_compact(allocator_t *allocator, process_table_t *table);
+int allocator_pages(int memory_strategy);
+void allocator_run(allocator_t *allocator, process_table_t *table, handle_t p, handle_t switched_out);
+int allocator_can_run(allocator_t *allocator, process_table_t *table, handle_t p, handle_t switched_out);
+uint32_t allocator_page_events(allocator_t *allocator, const page_event_t **events);
+
+#endif
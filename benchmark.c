@@ -0,0 +1,117 @@
+#include<time.h>
+#include<fcntl.h>
+#include"allocate.h"
+
+// Times each phase of allocate for every scheduler, memory strategy and quantum, one CSV
+// row per combination and trace. Parsing is timed once per trace, simulation with the
+// events discarded, and output by formatting the events of a captured run as text.
+// usage: ./benchmark trace.txt... > bench.csv
+
+#define CAPTURE_INITIAL_CAPACITY 4096
+
+// the process events of one run, names point into the trace table
+typedef struct {
+    event_record_t record;
+    const char *name;
+    int name_length;
+} captured_event_t;
+
+typedef struct {
+    captured_event_t *events;
+    size_t count;
+    size_t capacity;
+} capture_t;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Runs one configuration over an already parsed trace, returns the wall time taken */
+static double time_simulation(trace_table_t *table, config_t *config, writer_t *out) {
+    double start = now_seconds();
+    simulation_t *sim = make_simulation(config, out);
+    sim->trace = open_table_trace(table, sim->processes);
+    schedule_processes(sim);
+    flush_writer(out);
+    free_simulation(sim);
+    return now_seconds() - start;
+}
+
+/* Keeps the process events, the summary lines are too few to time */
+static void capture_event(void *context, const event_record_t *record, const char *name, int name_length) {
+    capture_t *capture = context;
+    if (name == NULL) return;
+
+    if (capture->count == capture->capacity) {
+        capture->capacity = capture->capacity ? 2 * capture->capacity : CAPTURE_INITIAL_CAPACITY;
+        capture->events = realloc(capture->events, capture->capacity * sizeof(captured_event_t));
+        assert(capture->events!=NULL);
+    }
+    capture->events[capture->count++] = (captured_event_t){ *record, name, name_length };
+}
+
+/* Formats the captured events as text, returns the wall time taken */
+static double time_output(capture_t *capture, writer_t *out) {
+    double start = now_seconds();
+    for (size_t i = 0; i < capture->count; i++) {
+        captured_event_t *e = &capture->events[i];
+        write_process_event(out, e->record.type, e->record.time, e->record.process_id, e->name, e->name_length,
+            e->record.field, e->record.cpu);
+    }
+    flush_writer(out);
+    return now_seconds() - start;
+}
+
+int main(int argc, char *argv[]) {
+    int null_fd = open("/dev/null", O_WRONLY);
+    if (argc < 2 || null_fd < 0) {
+        fprintf(stderr, "usage: %s trace.txt...\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    writer_t *discard = make_writer(-1, DISCARD, 1);
+    writer_t *text = make_writer(null_fd, TEXT, 1);
+    capture_t capture = { NULL, 0, 0 };
+    writer_t *capturing = make_callback_writer(capture_event, &capture, 1);
+
+    printf("trace,processes,scheduler,memory,quantum,parse_seconds,simulate_seconds,output_seconds\n");
+    for (int i = 1; i < argc; i++) {
+        double start = now_seconds();
+        char error[TRACE_ERROR_BYTES];
+        trace_table_t *table = load_trace_table(argv[i], error);
+        if (table == NULL) {
+            fprintf(stderr, "%s\n", error);
+            exit(EXIT_FAILURE);
+        }
+        double parse = now_seconds() - start;
+
+        for (int strategy = SJF; strategy < SCHEDULER_COUNT; strategy++) {
+            for (int memory_strategy = INFINITE; memory_strategy < MEMORY_STRATEGY_COUNT; memory_strategy++) {
+                for (int quantum = 1; quantum <= 3; quantum++) {
+                    config_t config = { strategy, memory_strategy, quantum, EVENT, MEMORY_MB, MEMORY_GRANULARITY };
+                    double simulate = time_simulation(table, &config, discard);
+                    capture.count = 0;
+                    time_simulation(table, &config, capturing);
+                    double output = time_output(&capture, text);
+
+                    printf("%s,%d,%s,%s,%d,%.6f,%.6f,%.6f\n", argv[i], table->count,
+                        scheduler_name(strategy), memory_strategy_name(memory_strategy),
+                        quantum, parse, simulate, output);
+                    fflush(stdout);
+                }
+            }
+        }
+
+        free_trace_table(table);
+    }
+
+    free_writer(discard);
+    free_writer(text);
+    free_writer(capturing);
+    free(capture.events);
+    close(null_fd);
+
+    return 0;
+}
@@ -0,0 +1,225 @@
+#include"buddy.h"
+
+// Per-order free bitmaps, a block is split by clearing its bit and setting its two halves'
+// bits one order down, and merged back while its buddy's bit is also set. Each bitmap has
+// summary levels over it, which only change when a word becomes empty or stops being empty
+
+static int64_t bitmap_words(buddy_t *buddy, int order) {
+    int64_t blocks = (int64_t)1 << (buddy->max_order - order);
+    return (blocks + 63) / 64;
+}
+
+/* Sets bit index of a bitmap, returns whether its word was empty before */
+static int set_bit(uint64_t *bits, int64_t index) {
+    uint64_t word = bits[index / 64];
+    bits[index / 64] = word | (uint64_t)1 << (index % 64);
+    return word == 0;
+}
+
+/* Clears bit index of a bitmap, returns whether its word is empty now */
+static int clear_bit(uint64_t *bits, int64_t index) {
+    bits[index / 64] &= ~((uint64_t)1 << (index % 64));
+    return bits[index / 64] == 0;
+}
+
+static void set_free(buddy_t *buddy, int order, int64_t block) {
+    int64_t index = block / 64;
+    if (set_bit(buddy->free_bits[order], block)) {
+        for (int level = 0; level < buddy->summary_levels[order] && set_bit(buddy->summary[order][level], index); level++) {
+            index /= 64;
+        }
+    }
+    buddy->free_count[order]++;
+    buddy->free_blocks++;
+    STAT_MAX(buddy->stats, max_holes, buddy->free_blocks);
+}
+
+static void clear_free(buddy_t *buddy, int order, int64_t block) {
+    int64_t index = block / 64;
+    if (clear_bit(buddy->free_bits[order], block)) {
+        for (int level = 0; level < buddy->summary_levels[order] && clear_bit(buddy->summary[order][level], index); level++) {
+            index /= 64;
+        }
+    }
+    buddy->free_count[order]--;
+    buddy->free_blocks--;
+}
+
+static int is_free(buddy_t *buddy, int order, int64_t block) {
+    return (buddy->free_bits[order][block / 64] >> (block % 64)) & 1;
+}
+
+/* Smallest order whose blocks hold the requirement */
+static int order_for(int64_t memory_requirement) {
+    int order = 0;
+    while (order < BUDDY_MAX_ORDERS - 1 && ((int64_t)1 << order) < memory_requirement) order++;
+    return order;
+}
+
+buddy_t* make_buddy(int64_t memory_units, stats_t *stats) {
+    buddy_t *buddy = calloc(1, sizeof(buddy_t));
+    assert(buddy!=NULL);
+    buddy->stats = stats;
+
+    while (buddy->max_order < BUDDY_MAX_ORDERS - 2 && ((int64_t)2 << buddy->max_order) <= memory_units) {
+        buddy->max_order++;
+    }
+
+    for (int order = 0; order <= buddy->max_order; order++) {
+        buddy->free_bits[order] = calloc(bitmap_words(buddy, order), sizeof(uint64_t));
+        assert(buddy->free_bits[order]!=NULL);
+
+        for (int64_t words = bitmap_words(buddy, order); words > 1; words = (words + 63) / 64) {
+            assert(buddy->summary_levels[order] < BUDDY_SUMMARY_LEVELS);
+            buddy->summary[order][buddy->summary_levels[order]] = calloc((words + 63) / 64, sizeof(uint64_t));
+            assert(buddy->summary[order][buddy->summary_levels[order]]!=NULL);
+            buddy->summary_levels[order]++;
+        }
+    }
+
+    set_free(buddy, buddy->max_order, 0);
+    buddy->free_memory = (int64_t)1 << buddy->max_order;
+
+    return buddy;
+}
+
+void free_buddy(buddy_t *buddy) {
+    for (int order = 0; order <= buddy->max_order; order++) {
+        free(buddy->free_bits[order]);
+        for (int level = 0; level < buddy->summary_levels[order]; level++) free(buddy->summary[order][level]);
+    }
+    free(buddy);
+}
+
+/* Lowest addressed free block of the smallest order that fits, split down to size.
+   Returns its start, or -1 if no block is large enough */
+int64_t buddy_allocate(buddy_t *buddy, int64_t memory_requirement) {
+    int order = order_for(memory_requirement), split = order;
+    STAT_DECLARE(uint64_t scanned = 0);
+
+    while (split <= buddy->max_order && buddy->free_count[split] == 0) {
+        STAT_ONLY(scanned++);
+        split++;
+    }
+    STAT_ADD(buddy->stats, hole_searches, 1);
+    if (split > buddy->max_order) {
+        STAT_ADD(buddy->stats, segments_scanned, scanned);
+        STAT_MAX(buddy->stats, max_segments_scanned, scanned);
+        return -1;
+    }
+
+    // follow the lowest set bit down from the single top word
+    int64_t word = 0;
+    for (int level = buddy->summary_levels[split] - 1; level >= 0; level--) {
+        STAT_ONLY(scanned++);
+        word = word * 64 + __builtin_ctzll(buddy->summary[split][level][word]);
+    }
+    STAT_ADD(buddy->stats, segments_scanned, scanned + 1);
+    STAT_MAX(buddy->stats, max_segments_scanned, scanned + 1);
+
+    int64_t block = word * 64 + __builtin_ctzll(buddy->free_bits[split][word]);
+    clear_free(buddy, split, block);
+
+    // keep the lower half, the upper half becomes free one order down
+    while (split > order) {
+        split--;
+        block *= 2;
+        set_free(buddy, split, block + 1);
+    }
+
+    buddy->free_memory -= (int64_t)1 << order;
+    return block << order;
+}
+
+/* Returns a block to the allocator, merging it with its buddy for as long as that is free */
+void buddy_free_block(buddy_t *buddy, int64_t mem_start, int64_t memory_requirement) {
+    int order = order_for(memory_requirement);
+    int64_t block = mem_start >> order;
+
+    buddy->free_memory += (int64_t)1 << order;
+
+    while (order < buddy->max_order && is_free(buddy, order, block ^ 1)) {
+        clear_free(buddy, order, block ^ 1);
+        block >>= 1;
+        order++;
+    }
+
+    set_free(buddy, order, block);
+}
+
+void buddy_stats(buddy_t *buddy, int *holes, int64_t *free_memory, int64_t *largest_hole) {
+    *holes = buddy->free_blocks;
+    *free_memory = buddy->free_memory;
+    *largest_hole = 0;
+
+    for (int order = buddy->max_order; order >= 0; order--) {
+        if (buddy->free_count[order]) {
+            *largest_hole = (int64_t)1 << order;
+            break;
+        }
+    }
+}
+
+/* Saves the bitmaps into buffer, returns the bytes they take. A NULL buffer only sizes them */
+size_t checkpoint_buddy(buddy_t *buddy, void *buffer) {
+    size_t length = sizeof(checkpoint_buddy_t);
+    for (int order = 0; order <= buddy->max_order; order++) length += bitmap_words(buddy, order) * sizeof(uint64_t);
+    if (!buffer) return length;
+
+    checkpoint_buddy_t *header = buffer;
+    header->max_order = buddy->max_order;
+    header->free_blocks = buddy->free_blocks;
+    header->free_memory = buddy->free_memory;
+    memcpy(header->free_count, buddy->free_count, sizeof(header->free_count));
+
+    uint64_t *words = (uint64_t *)(header + 1);
+    for (int order = 0; order <= buddy->max_order; order++) {
+        memcpy(words, buddy->free_bits[order], bitmap_words(buddy, order) * sizeof(uint64_t));
+        words += bitmap_words(buddy, order);
+    }
+
+    return length;
+}
+
+/* Replaces the bitmaps with saved ones, returns -1 unless the memory size matches and no bit is
+   set past the end of the memory */
+int restore_buddy(buddy_t *buddy, const void *data, size_t length) {
+    const checkpoint_buddy_t *header = data;
+    if (length != checkpoint_buddy(buddy, NULL) || header->max_order != buddy->max_order) return -1;
+
+    // the counts are taken from the bits rather than trusted to agree with them
+    const uint64_t *words = (const uint64_t *)(header + 1);
+    for (int order = 0; order <= buddy->max_order; order++) {
+        int64_t blocks = (int64_t)1 << (buddy->max_order - order);
+        if (blocks % 64 && words[blocks / 64] >> (blocks % 64)) return -1;
+        words += bitmap_words(buddy, order);
+    }
+
+    buddy->free_blocks = 0;
+    buddy->free_memory = 0;
+    words = (const uint64_t *)(header + 1);
+    for (int order = 0; order <= buddy->max_order; order++) {
+        memcpy(buddy->free_bits[order], words, bitmap_words(buddy, order) * sizeof(uint64_t));
+        buddy->free_count[order] = 0;
+        for (int64_t i = 0; i < bitmap_words(buddy, order); i++) {
+            buddy->free_count[order] += __builtin_popcountll(words[i]);
+        }
+
+        // the summaries are rebuilt from the bits, each level from the one below it
+        const uint64_t *below = buddy->free_bits[order];
+        int64_t below_words = bitmap_words(buddy, order);
+        for (int level = 0; level < buddy->summary_levels[order]; level++) {
+            uint64_t *summary = buddy->summary[order][level];
+            memset(summary, 0, (below_words + 63) / 64 * sizeof(uint64_t));
+            for (int64_t i = 0; i < below_words; i++) {
+                if (below[i]) set_bit(summary, i);
+            }
+            below = summary;
+            below_words = (below_words + 63) / 64;
+        }
+        buddy->free_blocks += buddy->free_count[order];
+        buddy->free_memory += (int64_t)buddy->free_count[order] << order;
+        words += bitmap_words(buddy, order);
+    }
+    return 0;
+}
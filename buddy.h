@@ -0,0 +1,46 @@
+#ifndef _BUDDY_H_
+#define _BUDDY_H_
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<stdint.h>
+#include<string.h>
+#include<assert.h>
+#include"stats.h"
+
+// blocks of 1 allocation unit (order 0) up to 2^(BUDDY_MAX_ORDERS-1) units
+#define BUDDY_MAX_ORDERS 40
+// 64-way summary levels above a bitmap of up to 2^(BUDDY_MAX_ORDERS-1) blocks, down to one word
+#define BUDDY_SUMMARY_LEVELS 6
+
+// binary buddy allocator over the largest power of two units that fits the memory
+typedef struct {
+    int max_order;                          // the whole memory is one block of this order
+    uint64_t *free_bits[BUDDY_MAX_ORDERS];  // bit i set while block i of that order is free
+    // bit i of level 0 set while word i of free_bits is not zero, and of level l while word i of
+    // level l-1 is not zero, so the lowest free block is found a word per level
+    uint64_t *summary[BUDDY_MAX_ORDERS][BUDDY_SUMMARY_LEVELS];
+    int summary_levels[BUDDY_MAX_ORDERS];
+    int free_count[BUDDY_MAX_ORDERS];       // free blocks of each order
+    int free_blocks;
+    int64_t free_memory;                    // units
+    stats_t *stats;
+} buddy_t;
+
+// the allocator as saved in a checkpoint, followed by the bitmap words of every order
+typedef struct {
+    int32_t max_order;
+    int32_t free_blocks;
+    int64_t free_memory;
+    int32_t free_count[BUDDY_MAX_ORDERS];
+} checkpoint_buddy_t;
+
+buddy_t* make_buddy(int64_t memory_units, stats_t *stats);
+void free_buddy(buddy_t *buddy);
+int64_t buddy_allocate(buddy_t *buddy, int64_t memory_requirement);
+void buddy_free_block(buddy_t *buddy, int64_t mem_start, int64_t memory_requirement);
+void buddy_stats(buddy_t *buddy, int *holes, int64_t *free_memory, int64_t *largest_hole);
+size_t checkpoint_buddy(buddy_t *buddy, void *buffer);
+int restore_buddy(buddy_t *buddy, const void *data, size_t length);
+
+#endif
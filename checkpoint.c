@@ -0,0 +1,552 @@
+#include"checkpoint.h"
+
+// sections are padded so that every array in the mapped file is aligned
+#define CHECKPOINT_ALIGN 8
+
+static size_t padded(size_t length) {
+    return (length + CHECKPOINT_ALIGN - 1) & ~(size_t)(CHECKPOINT_ALIGN - 1);
+}
+
+/* The FIFOs of a CPU's ready queue, one for RR, one per level for MLFQ and none for SJF */
+static int cpu_queues(cpu_t *cpu, queue_t **queues) {
+    ready_q_t *rq = cpu->ready_q;
+
+    if (rq->strategy == RR) {
+        queues[0] = rq->fifo;
+        return 1;
+    }
+    if (rq->strategy == MLFQ) {
+        for (int i = 0; i < rq->mlfq->levels; i++) queues[i] = rq->mlfq->queues[i];
+        return rq->mlfq->levels;
+    }
+    return 0;
+}
+
+static int write_section(FILE *file, const void *data, size_t length) {
+    static const char zeros[CHECKPOINT_ALIGN];
+
+    if (length && fwrite(data, 1, length, file) != length) return -1;
+    if (padded(length) != length && fwrite(zeros, 1, padded(length) - length, file) != padded(length) - length) {
+        return -1;
+    }
+    return 0;
+}
+
+/* Every process the simulation holds, running, ready or waiting for memory. Processes the
+   trace has read ahead are not part of the state, a restored run reads them again */
+static uint32_t live_processes(simulation_t *sim, handle_t *live) {
+    process_table_t *table = sim->processes;
+    queue_t *queues[MLFQ_MAX_LEVELS];
+    uint32_t count = 0;
+
+    for (handle_t p = sim->input_q->head; p != NO_PROCESS; p = table->next[p]) live[count++] = p;
+
+    for (int c = 0; c < sim->config.cpus; c++) {
+        cpu_t *cpu = &sim->cpus[c];
+        if (cpu->running != NO_PROCESS) live[count++] = cpu->running;
+
+        int queue_count = cpu_queues(cpu, queues);
+        for (int i = 0; i < queue_count; i++) {
+            for (handle_t p = queues[i]->head; p != NO_PROCESS; p = table->next[p]) live[count++] = p;
+        }
+        if (cpu->ready_q->strategy == SJF) {
+            for (int i = 0; i < cpu->ready_q->heap->count; i++) live[count++] = cpu->ready_q->heap->entries[i].p;
+        }
+    }
+
+    return count;
+}
+
+/* Writes the whole state of a run at the top of a cycle, returns -1 if the file cannot be written */
+int write_checkpoint(simulation_t *sim, const char *filename) {
+    process_table_t *table = sim->processes;
+    queue_t *queues[MLFQ_MAX_LEVELS];
+    int cpu_count = sim->config.cpus;
+
+    FILE *file = fopen(filename, "wb");
+    if (file == NULL) return -1;
+
+    handle_t *live = malloc((table->count + 1) * sizeof(handle_t));
+    assert(live!=NULL);
+    uint32_t process_count = live_processes(sim, live);
+
+    checkpoint_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic));
+    header.strategy = sim->config.strategy;
+    header.memory_strategy = sim->config.memory_strategy;
+    header.quantum = sim->config.quantum;
+    header.memory_mb = sim->config.memory_mb;
+    header.granularity = sim->config.granularity;
+    header.cpus = cpu_count;
+    header.mlfq_levels = sim->config.mlfq_levels;
+    header.mlfq_boost = sim->config.mlfq_boost;
+    for (int i = 0; i < MLFQ_MAX_LEVELS; i++) header.mlfq_slices[i] = sim->config.mlfq_slices[i];
+    header.compaction = sim->config.compaction;
+    header.compaction_cost = sim->config.compaction_cost;
+    header.admission = sim->config.admission;
+
+    header.simulated_time = sim->simulated_time;
+    header.num_cycles = sim->num_cycles;
+    header.turnaround_time = sim->turnaround_time;
+    header.num_processes = sim->num_processes;
+    header.trace_hash = sim->trace ? trace_consumed(sim->trace).hash : 0;
+    header.trace_length = sim->trace ? trace_consumed(sim->trace).length : 0;
+    header.next_boost = sim->next_boost;
+    header.total_overhead = sim->total_overhead;
+    header.max_overhead = sim->max_overhead;
+    header.compactions = sim->admission.compactions;
+    header.compacted_mb = sim->admission.compacted_mb;
+    header.compaction_stall = sim->admission.compaction_stall;
+    header.reserved_process = sim->admission.reserved;
+    header.tried_foot = sim->admission.tried_foot;
+    header.tried_count = sim->admission.tried_count;
+    header.memory_freed = sim->allocator && sim->allocator->generation != sim->admission.generation;
+    header.reservation_time = sim->admission.reservation_time;
+    header.reservations = sim->admission.reservations;
+    header.reservation_hits = sim->admission.reservation_hits;
+    header.reservation_misses = sim->admission.reservation_misses;
+
+    header.table_capacity = table->capacity;
+    header.process_count = process_count;
+    header.queue_count = 1;
+    for (int c = 0; c < cpu_count; c++) {
+        header.queue_count += cpu_queues(&sim->cpus[c], queues);
+        if (sim->cpus[c].ready_q->strategy == SJF) header.heap_entry_count += sim->cpus[c].ready_q->heap->count;
+    }
+    for (uint32_t i = 0; i < process_count; i++) header.names_length += table->name_length[live[i]];
+    if (sim->allocator) header.allocator_length = allocator_checkpoint(sim->allocator, NULL);
+    if (sim->stats) header.stats_length = sizeof(stats_t);
+    if (sim->histograms) header.histograms_length = HISTOGRAM_COUNT * sizeof(histogram_t);
+
+    // processes and their names
+    checkpoint_process_t *processes = calloc(process_count + 1, sizeof(checkpoint_process_t));
+    char *names = malloc(header.names_length + 1);
+    assert(processes!=NULL && names!=NULL);
+    uint32_t name_offset = 0;
+    for (uint32_t i = 0; i < process_count; i++) {
+        handle_t p = live[i];
+        checkpoint_process_t *saved = &processes[i];
+        saved->handle = p;
+        saved->id = table->id[p];
+        saved->time_arrived = table->time_arrived[p];
+        saved->service_time = table->service_time[p];
+        saved->memory_requirement = table->memory_requirement[p];
+        saved->time_ran = table->time_ran[p];
+        saved->wait_time = table->wait_time[p];
+        saved->slice_used = table->slice_used[p];
+        saved->mem_start = table->mem_start[p];
+        saved->next = table->next[p];
+        saved->state = table->state[p];
+        saved->level = table->level[p];
+        saved->name_offset = name_offset;
+        saved->name_length = table->name_length[p];
+        memcpy(names + name_offset, process_name(table, p), table->name_length[p]);
+        name_offset += table->name_length[p];
+    }
+
+    // CPUs, queues and heaps
+    checkpoint_cpu_t *cpus = calloc(cpu_count, sizeof(checkpoint_cpu_t));
+    checkpoint_queue_t *saved_queues = calloc(header.queue_count, sizeof(checkpoint_queue_t));
+    checkpoint_heap_entry_t *heap_entries = calloc(header.heap_entry_count + 1, sizeof(checkpoint_heap_entry_t));
+    assert(cpus!=NULL && saved_queues!=NULL && heap_entries!=NULL);
+
+    saved_queues[0] = (checkpoint_queue_t){ sim->input_q->head, sim->input_q->foot, sim->input_q->count };
+    uint32_t queue_index = 1, heap_index = 0;
+    for (int c = 0; c < cpu_count; c++) {
+        cpu_t *cpu = &sim->cpus[c];
+        cpus[c].running = cpu->running;
+        cpus[c].last_finish = cpu->last_finish;
+        cpus[c].busy_time = cpu->busy_time;
+
+        int queue_count = cpu_queues(cpu, queues);
+        for (int i = 0; i < queue_count; i++) {
+            saved_queues[queue_index++] = (checkpoint_queue_t){ queues[i]->head, queues[i]->foot, queues[i]->count };
+        }
+
+        if (cpu->ready_q->strategy == SJF) {
+            heap_t *heap = cpu->ready_q->heap;
+            cpus[c].heap_next_seq = heap->next_seq;
+            cpus[c].heap_count = heap->count;
+            for (int i = 0; i < heap->count; i++, heap_index++) {
+                heap_entries[heap_index].seq = heap->entries[i].seq;
+                heap_entries[heap_index].service_time = heap->entries[i].service_time;
+                heap_entries[heap_index].p = heap->entries[i].p;
+            }
+        }
+    }
+
+    void *allocator_state = NULL;
+    if (header.allocator_length) {
+        allocator_state = malloc(header.allocator_length);
+        assert(allocator_state!=NULL);
+        allocator_checkpoint(sim->allocator, allocator_state);
+    }
+
+    int error = write_section(file, &header, sizeof(header))
+        || write_section(file, processes, process_count * sizeof(checkpoint_process_t))
+        || write_section(file, names, header.names_length)
+        || write_section(file, cpus, cpu_count * sizeof(checkpoint_cpu_t))
+        || write_section(file, saved_queues, header.queue_count * sizeof(checkpoint_queue_t))
+        || write_section(file, heap_entries, header.heap_entry_count * sizeof(checkpoint_heap_entry_t))
+        || write_section(file, allocator_state, header.allocator_length)
+        || write_section(file, sim->stats, header.stats_length)
+        || write_section(file, sim->histograms, header.histograms_length);
+    if (fclose(file) != 0) error = 1;
+
+    free(live);
+    free(processes);
+    free(names);
+    free(cpus);
+    free(saved_queues);
+    free(heap_entries);
+    free(allocator_state);
+
+    return error ? -1 : 0;
+}
+
+/* Bytes a checkpoint with this header takes */
+static size_t checkpoint_length(const checkpoint_header_t *header) {
+    return padded(sizeof(checkpoint_header_t))
+        + padded(header->process_count * sizeof(checkpoint_process_t))
+        + padded(header->names_length)
+        + padded(header->cpus * sizeof(checkpoint_cpu_t))
+        + padded(header->queue_count * sizeof(checkpoint_queue_t))
+        + padded(header->heap_entry_count * sizeof(checkpoint_heap_entry_t))
+        + padded(header->allocator_length)
+        + padded(header->stats_length)
+        + padded(header->histograms_length);
+}
+
+/* Whether p is a handle in the table as saved, NO_PROCESS is taken for an empty link */
+static int valid_link(const uint32_t *index, uint32_t capacity, handle_t p) {
+    return p == NO_PROCESS || (p < capacity && index[p] != NO_PROCESS);
+}
+
+/* Marks p as found somewhere in the saved queues, CPUs or heaps, a process can only be in one */
+static int mark_placed(const uint32_t *index, uint8_t *placed, uint32_t capacity, handle_t p) {
+    if (p == NO_PROCESS || !valid_link(index, capacity, p) || placed[index[p]]) return 0;
+    placed[index[p]] = 1;
+    return 1;
+}
+
+/* Whether a saved FIFO links exactly count processes from head to foot */
+static int valid_queue(const checkpoint_queue_t *queue, const checkpoint_process_t *processes,
+    const uint32_t *index, uint8_t *placed, uint32_t capacity) {
+    if (queue->count < 0 || (queue->count == 0) != (queue->head == NO_PROCESS)
+        || (queue->head == NO_PROCESS) != (queue->foot == NO_PROCESS)) {
+        return 0;
+    }
+
+    handle_t p = queue->head, last = NO_PROCESS;
+    for (int32_t i = 0; i < queue->count; i++) {
+        if (!mark_placed(index, placed, capacity, p)) return 0;
+        last = p;
+        p = processes[index[p]].next;
+    }
+    return p == NO_PROCESS && last == queue->foot;
+}
+
+/* Whether p is NO_PROCESS or linked from a saved queue already found valid */
+static int in_queue(const checkpoint_queue_t *queue, const checkpoint_process_t *processes,
+    const uint32_t *index, handle_t p) {
+    if (p == NO_PROCESS) return 1;
+    for (handle_t q = queue->head; q != NO_PROCESS; q = processes[index[q]].next) {
+        if (q == p) return 1;
+    }
+    return 0;
+}
+
+/* Whether the sections of a checkpoint hold a consistent state, so that restoring it only ever
+   touches handles below table_capacity. Every process has to be found exactly once in the input
+   queue, on a CPU or in a ready queue */
+static int valid_sections(const checkpoint_header_t *header, const char *map) {
+    const char *section = map + padded(sizeof(checkpoint_header_t));
+    const checkpoint_process_t *processes = (const checkpoint_process_t *)section;
+    section += padded(header->process_count * sizeof(checkpoint_process_t));
+    section += padded(header->names_length);
+    const checkpoint_cpu_t *cpus = (const checkpoint_cpu_t *)section;
+    section += padded(header->cpus * sizeof(checkpoint_cpu_t));
+    const checkpoint_queue_t *saved_queues = (const checkpoint_queue_t *)section;
+    section += padded(header->queue_count * sizeof(checkpoint_queue_t));
+    const checkpoint_heap_entry_t *heap_entries = (const checkpoint_heap_entry_t *)section;
+
+    uint32_t capacity = header->table_capacity;
+    int levels = header->strategy == MLFQ ? header->mlfq_levels : 1;
+    int queues_per_cpu = header->strategy == RR ? 1 : header->strategy == MLFQ ? header->mlfq_levels : 0;
+    // the table only ever doubles from its initial capacity
+    if (capacity < PROCESS_TABLE_INITIAL_CAPACITY || (capacity & (capacity - 1)) || header->process_count > capacity
+        || header->queue_count != 1 + (uint32_t)header->cpus * queues_per_cpu
+        || (header->strategy != SJF && header->heap_entry_count > 0)) {
+        return 0;
+    }
+
+    // the saved position of each handle, NO_PROCESS for slots that were free
+    uint32_t *index = malloc(((size_t)capacity + 1) * sizeof(uint32_t));
+    uint8_t *placed = calloc(header->process_count + 1, 1);
+    int valid = index != NULL && placed != NULL;
+    if (valid) memset(index, 0xff, ((size_t)capacity + 1) * sizeof(uint32_t));
+
+    for (uint32_t i = 0; i < header->process_count && valid; i++) {
+        const checkpoint_process_t *saved = &processes[i];
+        valid = saved->handle < capacity && index[saved->handle] == NO_PROCESS
+            && saved->state >= ARRIVED && saved->state <= RUNNING && saved->level < levels
+            && saved->name_length >= 0 && saved->name_offset <= header->names_length
+            && (uint64_t)saved->name_length <= header->names_length - saved->name_offset
+            && saved->memory_requirement >= 0;
+        if (valid) index[saved->handle] = i;
+    }
+    for (uint32_t i = 0; i < header->process_count && valid; i++) {
+        valid = valid_link(index, capacity, processes[i].next);
+    }
+
+    uint64_t heap_entries_found = 0;
+    for (int c = 0; c < header->cpus && valid; c++) {
+        valid = (cpus[c].running == NO_PROCESS || mark_placed(index, placed, capacity, cpus[c].running))
+            && cpus[c].heap_count <= header->heap_entry_count - heap_entries_found;
+        heap_entries_found += cpus[c].heap_count;
+    }
+    valid = valid && heap_entries_found == header->heap_entry_count;
+    for (uint32_t i = 0; i < header->queue_count && valid; i++) {
+        valid = valid_queue(&saved_queues[i], processes, index, placed, capacity);
+    }
+    for (uint32_t i = 0; i < header->heap_entry_count && valid; i++) {
+        valid = mark_placed(index, placed, capacity, heap_entries[i].p);
+    }
+    for (uint32_t i = 0; i < header->process_count && valid; i++) valid = placed[i];
+    // admission picks up from these, both are left waiting in the input queue
+    valid = valid && in_queue(&saved_queues[0], processes, index, header->tried_foot)
+        && in_queue(&saved_queues[0], processes, index, header->reserved_process);
+
+    free(index);
+    free(placed);
+    return valid;
+}
+
+/* Maps a checkpoint file, NULL if it cannot be read or is not a checkpoint */
+checkpoint_t* open_checkpoint(const char *filename) {
+    int fd = open(filename, O_RDONLY);
+    if (fd == -1) return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) == -1 || (size_t)st.st_size < sizeof(checkpoint_header_t)) {
+        close(fd);
+        return NULL;
+    }
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return NULL;
+
+    // no section can be longer than the file, which also keeps their sum from overflowing
+    const checkpoint_header_t *header = map;
+    size_t length = st.st_size;
+    int valid = memcmp(header->magic, CHECKPOINT_MAGIC, sizeof(header->magic)) == 0
+        && header->strategy >= 0 && header->strategy < SCHEDULER_COUNT
+        && (header->admission == GREEDY || header->admission == BACKFILL)
+        && header->memory_strategy >= 0 && header->memory_strategy < MEMORY_STRATEGY_COUNT
+        && header->quantum >= 1
+        && header->cpus >= 1 && header->cpus <= MAX_CPUS
+        && header->memory_mb >= 1 && header->memory_mb <= MAX_MEMORY_MB
+        && header->granularity >= MIN_GRANULARITY && !(header->granularity & (header->granularity - 1))
+        && header->mlfq_levels >= 1 && header->mlfq_levels <= MLFQ_MAX_LEVELS
+        && header->mlfq_boost >= 1
+        && header->process_count <= length / sizeof(checkpoint_process_t)
+        && header->queue_count <= length / sizeof(checkpoint_queue_t)
+        && header->heap_entry_count <= length / sizeof(checkpoint_heap_entry_t)
+        && header->names_length <= length && header->allocator_length <= length
+        && header->stats_length <= length && header->histograms_length <= length
+        && checkpoint_length(header) == length;
+    for (int i = 0; valid && i < header->mlfq_levels; i++) valid = header->mlfq_slices[i] >= 1;
+    if (!valid || !valid_sections(header, map)) {
+        munmap(map, st.st_size);
+        return NULL;
+    }
+
+    checkpoint_t *checkpoint = malloc(sizeof(checkpoint_t));
+    assert(checkpoint!=NULL);
+    checkpoint->map = map;
+    checkpoint->length = st.st_size;
+    checkpoint->header = header;
+
+    config_t *config = &checkpoint->config;
+    memset(config, 0, sizeof(config_t));
+    config->strategy = header->strategy;
+    config->memory_strategy = header->memory_strategy;
+    config->quantum = header->quantum;
+    config->time_advance = EVENT;
+    config->memory_mb = header->memory_mb;
+    config->granularity = header->granularity;
+    config->cpus = header->cpus;
+    config->mlfq_levels = header->mlfq_levels;
+    config->mlfq_boost = header->mlfq_boost;
+    for (int i = 0; i < MLFQ_MAX_LEVELS; i++) config->mlfq_slices[i] = header->mlfq_slices[i];
+    config->compaction = header->compaction;
+    config->compaction_cost = header->compaction_cost;
+    config->admission = header->admission;
+
+    return checkpoint;
+}
+
+/* Puts a freshly made simulation into the state saved in a checkpoint. The simulation has to be
+   made from the checkpoint's configuration, and its trace opened afterwards. Returns -1 if the
+   saved memory does not fit the allocator or the processes said to hold it */
+int restore_checkpoint(simulation_t *sim, checkpoint_t *checkpoint) {
+    const checkpoint_header_t *header = checkpoint->header;
+    const char *section = checkpoint->map + padded(sizeof(checkpoint_header_t));
+    const checkpoint_process_t *processes = (const checkpoint_process_t *)section;
+    section += padded(header->process_count * sizeof(checkpoint_process_t));
+    const char *names = section;
+    section += padded(header->names_length);
+    const checkpoint_cpu_t *cpus = (const checkpoint_cpu_t *)section;
+    section += padded(header->cpus * sizeof(checkpoint_cpu_t));
+    const checkpoint_queue_t *saved_queues = (const checkpoint_queue_t *)section;
+    section += padded(header->queue_count * sizeof(checkpoint_queue_t));
+    const checkpoint_heap_entry_t *heap_entries = (const checkpoint_heap_entry_t *)section;
+    section += padded(header->heap_entry_count * sizeof(checkpoint_heap_entry_t));
+    const void *allocator_state = section;
+    section += padded(header->allocator_length);
+    const void *stats = section;
+    section += padded(header->stats_length);
+    const histogram_t *histograms = (const histogram_t *)section;
+
+    process_table_t *table = sim->processes;
+    queue_t *queues[MLFQ_MAX_LEVELS];
+
+    sim->simulated_time = header->simulated_time;
+    sim->num_cycles = header->num_cycles;
+    sim->turnaround_time = header->turnaround_time;
+    sim->num_processes = header->num_processes;
+    sim->next_boost = header->next_boost;
+    sim->total_overhead = header->total_overhead;
+    sim->max_overhead = header->max_overhead;
+    sim->admission.compactions = header->compactions;
+    sim->admission.compacted_mb = header->compacted_mb;
+    sim->admission.compaction_stall = header->compaction_stall;
+    sim->admission.reserved = sim->admission.backfill ? header->reserved_process : NO_PROCESS;
+    sim->admission.reservation_time = header->reservation_time;
+    sim->admission.reservations = header->reservations;
+    sim->admission.reservation_hits = header->reservation_hits;
+    sim->admission.reservation_misses = header->reservation_misses;
+
+    // processes go back under their own handles, so queue links stay valid as saved
+    uint8_t *live = calloc(header->table_capacity + 1, 1);
+    assert(live!=NULL);
+    for (uint32_t i = 0; i < header->process_count; i++) live[processes[i].handle] = 1;
+    claim_process_slots(table, live, header->table_capacity);
+    free(live);
+
+    for (uint32_t i = 0; i < header->process_count; i++) {
+        const checkpoint_process_t *saved = &processes[i];
+        handle_t p = saved->handle;
+        table->id[p] = saved->id;
+        table->time_arrived[p] = saved->time_arrived;
+        table->service_time[p] = saved->service_time;
+        table->memory_requirement[p] = saved->memory_requirement;
+        table->time_ran[p] = saved->time_ran;
+        table->wait_time[p] = saved->wait_time;
+        table->slice_used[p] = saved->slice_used;
+        table->mem_start[p] = saved->mem_start;
+        table->next[p] = saved->next;
+        table->state[p] = saved->state;
+        table->level[p] = saved->level;
+        table->segment[p] = NO_SEGMENT;
+        // names are copied, the trace releases them like its own once the process finishes
+        table->name[p] = arena_add_string(sim->name_arena, names + saved->name_offset, saved->name_length);
+        table->name_length[p] = saved->name_length;
+    }
+
+    sim->input_q->head = saved_queues[0].head;
+    sim->input_q->foot = saved_queues[0].foot;
+    sim->input_q->count = saved_queues[0].count;
+
+    uint32_t queue_index = 1, heap_index = 0;
+    for (int c = 0; c < sim->config.cpus; c++) {
+        cpu_t *cpu = &sim->cpus[c];
+        cpu->running = cpus[c].running;
+        cpu->last_finish = cpus[c].last_finish;
+        cpu->busy_time = cpus[c].busy_time;
+
+        int queue_count = cpu_queues(cpu, queues);
+        for (int i = 0; i < queue_count; i++, queue_index++) {
+            queues[i]->head = saved_queues[queue_index].head;
+            queues[i]->foot = saved_queues[queue_index].foot;
+            queues[i]->count = saved_queues[queue_index].count;
+        }
+
+        if (cpu->ready_q->strategy == MLFQ) {
+            mlfq_t *mlfq = cpu->ready_q->mlfq;
+            for (int i = 0; i < mlfq->levels; i++) {
+                if (queue_is_empty(mlfq->queues[i])) continue;
+                mlfq->bitmap |= (uint64_t)1 << i;
+                mlfq->count += mlfq->queues[i]->count;
+            }
+        }
+
+        // the saved array is already a valid heap, sequence numbers keep ties in arrival order
+        if (cpu->ready_q->strategy == SJF) {
+            heap_t *heap = cpu->ready_q->heap;
+            if ((uint32_t)heap->capacity < cpus[c].heap_count) {
+                heap->capacity = cpus[c].heap_count;
+                heap->entries = realloc(heap->entries, heap->capacity * sizeof(heap_entry_t));
+                assert(heap->entries!=NULL);
+            }
+            for (uint32_t i = 0; i < cpus[c].heap_count; i++, heap_index++) {
+                heap->entries[i].seq = heap_entries[heap_index].seq;
+                heap->entries[i].service_time = heap_entries[heap_index].service_time;
+                heap->entries[i].p = heap_entries[heap_index].p;
+            }
+            heap->count = cpus[c].heap_count;
+            heap->next_seq = cpus[c].heap_next_seq;
+        }
+    }
+
+    if (sim->allocator && header->allocator_length
+        && allocator_restore(sim->allocator, table, allocator_state, header->allocator_length) != 0) {
+        return -1;
+    }
+    // a process holding a block has to hold it inside the memory, and under the segment list in
+    // a segment of its own. Pages are checked by the pager
+    if (sim->allocator && !allocator_pages(sim->config.memory_strategy)) {
+        int segments = allocators_share_state(sim->config.memory_strategy, BESTFIT);
+        for (uint32_t i = 0; i < header->process_count; i++) {
+            const checkpoint_process_t *saved = &processes[i];
+            if (saved->state == ARRIVED) continue;
+            if (saved->mem_start < 0 || saved->memory_requirement > sim->allocator->capacity_mb - saved->mem_start
+                || (segments && (table->segment[saved->handle] == NO_SEGMENT
+                    || memory_segment(sim->allocator->state, table->segment[saved->handle])->process != saved->handle))) {
+                return -1;
+            }
+        }
+    }
+    // the next admission pass tries only what the uninterrupted run would, unless memory changed
+    sim->admission.tried_foot = header->tried_foot;
+    sim->admission.tried_count = header->tried_count;
+    if (sim->allocator && !header->memory_freed && header->memory_strategy == sim->config.memory_strategy) {
+        sim->admission.generation = sim->allocator->generation;
+    }
+    if (sim->stats && header->stats_length == sizeof(stats_t)) memcpy(sim->stats, stats, sizeof(stats_t));
+    // the values recorded before the checkpoint count towards the restored run's percentiles
+    if (sim->histograms && header->histograms_length == HISTOGRAM_COUNT * sizeof(histogram_t)) {
+        for (int i = 0; i < HISTOGRAM_COUNT; i++) {
+            if (histograms[i].scale == sim->histograms[i].scale) histogram_merge(&sim->histograms[i], &histograms[i]);
+        }
+    }
+    return 0;
+}
+
+/* Drops the processes of sim->trace the checkpointed run had already read. Returns -1 if their
+   lines are not those the run read them from, the trace is not the one it was taken from */
+int skip_checkpoint_trace(simulation_t *sim, checkpoint_t *checkpoint) {
+    skip_trace_processes(sim->trace, sim->num_processes);
+
+    trace_line_t consumed = trace_consumed(sim->trace);
+    if (consumed.hash != checkpoint->header->trace_hash || consumed.length != checkpoint->header->trace_length) {
+        return -1;
+    }
+    return 0;
+}
+
+void close_checkpoint(checkpoint_t *checkpoint) {
+    munmap((void *)checkpoint->map, checkpoint->length);
+    free(checkpoint);
+}
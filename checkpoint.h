@@ -0,0 +1,126 @@
+#ifndef _CHECKPOINT_H_
+#define _CHECKPOINT_H_
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<stdint.h>
+#include<fcntl.h>
+#include<unistd.h>
+#include<sys/mman.h>
+#include<sys/stat.h>
+#include"allocate.h"
+
+#define CHECKPOINT_MAGIC "PMCKPT06"
+
+// A checkpoint file is this header followed by, each padded to 8 bytes:
+//   checkpoint_process_t    process_count live processes
+//   char                    names_length bytes of process names
+//   checkpoint_cpu_t        one per CPU
+//   checkpoint_queue_t      the input queue, then each CPU's FIFO for RR or its levels for MLFQ
+//   checkpoint_heap_entry_t each CPU's SJF heap in array order
+//   allocator state         allocator_length bytes, as saved by the allocator
+//   stats_t                 stats_length bytes, only from a STATS=1 build
+//   histogram_t             histograms_length bytes, HISTOGRAM_COUNT of them if they were recorded
+typedef struct {
+    char magic[8];
+    int32_t strategy;
+    int32_t memory_strategy;
+    int32_t quantum;
+    int32_t cpus;
+    int64_t memory_mb;
+    int64_t granularity;
+    int32_t mlfq_levels;
+    int32_t compaction;
+    int64_t mlfq_boost;
+    int64_t mlfq_slices[MLFQ_MAX_LEVELS];
+    double compaction_cost;
+    int32_t admission;
+    int32_t reserved;
+
+    int64_t simulated_time;
+    int64_t num_cycles;
+    int64_t turnaround_time;
+    int64_t num_processes;      // read from the trace so far
+    uint64_t trace_hash;        // and the lines they were read from, see trace_consumed
+    uint64_t trace_length;
+    int64_t next_boost;
+    double total_overhead;
+    double max_overhead;
+    int64_t compactions;
+    int64_t compacted_mb;
+    int64_t compaction_stall;
+    uint32_t reserved_process;  // holding the backfilling reservation
+    uint32_t tried_foot;        // input queue foot after the last admission pass
+    int32_t tried_count;
+    int32_t memory_freed;       // since the last admission pass, every process is retried
+    int64_t reservation_time;
+    int64_t reservations;
+    int64_t reservation_hits;
+    int64_t reservation_misses;
+
+    uint32_t table_capacity;
+    uint32_t process_count;
+    uint32_t queue_count;
+    uint32_t heap_entry_count;
+    uint64_t names_length;
+    uint64_t allocator_length;
+    uint64_t stats_length;
+    uint64_t histograms_length;
+} checkpoint_header_t;
+
+// a live process under the handle it had
+typedef struct {
+    uint32_t handle;
+    uint32_t id;
+    int64_t time_arrived;
+    int64_t service_time;
+    int64_t memory_requirement;
+    int64_t time_ran;
+    int64_t wait_time;
+    int64_t slice_used;
+    int64_t mem_start;
+    uint32_t next;
+    int8_t state;
+    uint8_t level;
+    uint16_t reserved;
+    uint32_t name_offset;       // into the names
+    int32_t name_length;
+} checkpoint_process_t;
+
+typedef struct {
+    uint32_t running;
+    uint32_t heap_count;
+    int64_t last_finish;
+    int64_t busy_time;
+    uint64_t heap_next_seq;
+} checkpoint_cpu_t;
+
+typedef struct {
+    uint32_t head;
+    uint32_t foot;
+    int32_t count;
+} checkpoint_queue_t;
+
+typedef struct {
+    uint64_t seq;
+    int64_t service_time;
+    uint32_t p;
+    uint32_t reserved;
+} checkpoint_heap_entry_t;
+
+// a checkpoint file mapped for restoring
+typedef struct {
+    const char *map;
+    size_t length;
+    const checkpoint_header_t *header;
+    config_t config;            // the run's configuration as saved
+} checkpoint_t;
+
+int write_checkpoint(simulation_t *sim, const char *filename);
+checkpoint_t* open_checkpoint(const char *filename);
+int restore_checkpoint(simulation_t *sim, checkpoint_t *checkpoint);
+int skip_checkpoint_trace(simulation_t *sim, checkpoint_t *checkpoint);
+void close_checkpoint(checkpoint_t *checkpoint);
+
+#endif
@@ -0,0 +1,139 @@
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<stdint.h>
+#include<assert.h>
+#include"output.h"
+
+#define NAMES_INITIAL_CAPACITY 1024
+
+// Decodes a binary event log written by allocate -o binary back into its text output
+// usage: ./decode < events.bin
+
+typedef struct {
+    char *name;
+    int length;
+} name_entry_t;
+
+static int read_record(event_record_t *r) {
+    return fread(r, sizeof(event_record_t), 1, stdin) == 1;
+}
+
+static double field_double(event_record_t *r) {
+    double value;
+    memcpy(&value, &r->field, sizeof(value));
+    return value;
+}
+
+/* The count of a *_STATS record, split between process_id and cpu */
+static int64_t stats_count(event_record_t *r) {
+    return (int64_t)r->cpu << 32 | r->process_id;
+}
+
+int main(int argc, char *argv[]) {
+    event_record_t r;
+    name_entry_t *names = calloc(NAMES_INITIAL_CAPACITY, sizeof(name_entry_t));
+    uint32_t capacity = NAMES_INITIAL_CAPACITY;
+    double turnaround = 0, max_overhead = 0, average_overhead = 0;
+    int64_t makespan = 0;
+    int64_t percentile_values[PERCENTILE_COUNT];
+    assert(names!=NULL);
+
+    if (!read_record(&r) || r.type != EVENT_HEADER || r.process_id != EVENT_LOG_MAGIC) {
+        fprintf(stderr, "Not an event log\n");
+        exit(EXIT_FAILURE);
+    }
+    if (r.field != EVENT_LOG_VERSION) {
+        fprintf(stderr, "Unsupported event log version %lld\n", (long long)r.field);
+        exit(EXIT_FAILURE);
+    }
+
+    writer_t *out = make_writer(STDOUT_FILENO, TEXT, r.cpu + 1);
+
+    while (read_record(&r)) {
+        switch (r.type) {
+            case EVENT_NAME: {
+                size_t padded = (r.field + sizeof(event_record_t) - 1) / sizeof(event_record_t) * sizeof(event_record_t);
+                while (r.process_id >= capacity) {
+                    names = realloc(names, 2 * capacity * sizeof(name_entry_t));
+                    assert(names!=NULL);
+                    memset(names + capacity, 0, capacity * sizeof(name_entry_t));
+                    capacity *= 2;
+                }
+                names[r.process_id].name = malloc(padded);
+                assert(names[r.process_id].name!=NULL);
+                names[r.process_id].length = r.field;
+                if (fread(names[r.process_id].name, 1, padded, stdin) != padded) {
+                    fprintf(stderr, "Truncated event log\n");
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            }
+            case EVENT_READY:
+            case EVENT_RUNNING:
+            case EVENT_FINISHED:
+            case EVENT_EVICTED:
+            case EVENT_FAULTED:
+                if (r.process_id >= capacity || !names[r.process_id].name) {
+                    fprintf(stderr, "Event for unnamed process %u\n", r.process_id);
+                    exit(EXIT_FAILURE);
+                }
+                write_process_event(out, r.type, r.time, r.process_id, 
+                    names[r.process_id].name, names[r.process_id].length, r.field, r.cpu);
+                // a finished process has no further events
+                if (r.type == EVENT_FINISHED) {
+                    free(names[r.process_id].name);
+                    names[r.process_id].name = NULL;
+                }
+                break;
+            case EVENT_TURNAROUND:
+                turnaround = field_double(&r);
+                break;
+            case EVENT_MAX_OVERHEAD:
+                max_overhead = field_double(&r);
+                break;
+            case EVENT_AVERAGE_OVERHEAD:
+                average_overhead = field_double(&r);
+                break;
+            case EVENT_MAKESPAN:
+                makespan = r.field;
+                write_statistics(out, turnaround, max_overhead, average_overhead, makespan);
+                break;
+            case EVENT_CPU:
+                write_cpu_statistics(out, r.cpu, r.field, r.time, makespan);
+                break;
+            case EVENT_LATENCY:
+                write_latency_statistics(out, r.cpu, r.process_id, r.time, r.field);
+                break;
+            case EVENT_COMPACTION:
+                write_compaction(out, r.time, r.field);
+                break;
+            case EVENT_COMPACTION_STATS:
+                write_compaction_statistics(out, stats_count(&r), r.field, r.time);
+                break;
+            case EVENT_PERCENTILE:
+                if (r.process_id >= PERCENTILE_COUNT || r.cpu >= HISTOGRAM_COUNT) {
+                    fprintf(stderr, "Unknown percentile %u of histogram %d\n", r.process_id, r.cpu);
+                    exit(EXIT_FAILURE);
+                }
+                percentile_values[r.process_id] = r.field;
+                if (r.process_id == PERCENTILE_COUNT - 1) write_percentiles(out, r.cpu, r.time, percentile_values);
+                break;
+            case EVENT_RESERVATION_STATS:
+                write_reservation_statistics(out, stats_count(&r), r.time, r.field);
+                break;
+            case EVENT_PAGING_STATS:
+                write_paging_statistics(out, stats_count(&r), r.time, r.field);
+                break;
+            default:
+                fprintf(stderr, "Unknown event type %d\n", r.type);
+                exit(EXIT_FAILURE);
+        }
+    }
+
+    free_writer(out);
+    for (uint32_t i = 0; i < capacity; i++) free(names[i].name);
+    free(names);
+
+    return 0;
+}
@@ -0,0 +1,226 @@
+#include"executor.h"
+
+#define EPOLL_BATCH 16
+
+// epoll data, a process handle and whether the event is its pidfd or the start pipe
+#define PIDFD_EVENT(p) (((uint64_t)(p) << 1) | 1)
+#define READY_EVENT(p) ((uint64_t)(p) << 1)
+
+extern char **environ;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void record_latency(latency_t *latency, uint64_t start) {
+    uint64_t ns = now_ns() - start;
+    latency->count++;
+    latency->total_ns += ns;
+    if (ns > latency->max_ns) latency->max_ns = ns;
+}
+
+/* Stops the executor, keeping the first reason for executor_error. Returns 0 */
+static int fail_executor(executor_t *ex, const char *format, ...) {
+    if (ex->error[0]) return 0;
+
+    va_list args;
+    va_start(args, format);
+    vsnprintf(ex->error, sizeof(ex->error), format, args);
+    va_end(args);
+    return 0;
+}
+
+/* Makes an executor, if epoll is not available the first process run fails the simulation */
+executor_t* make_executor(const char *workload) {
+    executor_t *ex = calloc(1, sizeof(executor_t));
+    assert(ex!=NULL);
+
+    ex->workload = workload;
+    ex->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (ex->epoll_fd == -1) fail_executor(ex, "epoll_create1: %s", strerror(errno));
+
+    return ex;
+}
+
+/* Why the executor stopped, NULL while it runs */
+const char* executor_error(executor_t *ex) {
+    return ex->error[0] ? ex->error : NULL;
+}
+
+/* Kills and reaps any children still alive */
+void free_executor(executor_t *ex) {
+    for (uint32_t p = 0; p < ex->capacity; p++) {
+        if (ex->pid[p]) executor_finish(ex, p);
+    }
+    if (ex->epoll_fd != -1) close(ex->epoll_fd);
+    free(ex->pid);
+    free(ex->pidfd);
+    free(ex->exited);
+    free(ex);
+}
+
+static void grow_executor(executor_t *ex, uint32_t capacity) {
+    uint32_t old_capacity = ex->capacity;
+
+    ex->pid = realloc(ex->pid, capacity * sizeof(pid_t));
+    ex->pidfd = realloc(ex->pidfd, capacity * sizeof(int));
+    ex->exited = realloc(ex->exited, capacity * sizeof(uint8_t));
+    assert(ex->pid!=NULL && ex->pidfd!=NULL && ex->exited!=NULL);
+
+    for (uint32_t p = old_capacity; p < capacity; p++) {
+        ex->pid[p] = 0;
+        ex->pidfd[p] = -1;
+        ex->exited[p] = 0;
+    }
+    ex->capacity = capacity;
+}
+
+/* A child died on its own, it stays a zombie until the simulation finishes its process */
+static void mark_exited(executor_t *ex, handle_t p) {
+    epoll_ctl(ex->epoll_fd, EPOLL_CTL_DEL, ex->pidfd[p], NULL);
+    ex->exited[p] = 1;
+    ex->unexpected_exits++;
+}
+
+/* Waits on the epoll set until the event wanted arrives, handling any child exits on the way.
+   Returns 0 if the child of the wanted start event exited instead, or epoll failed */
+static int wait_for_event(executor_t *ex, uint64_t wanted) {
+    struct epoll_event events[EPOLL_BATCH];
+    handle_t wanted_process = wanted >> 1;
+
+    for (;;) {
+        int n = epoll_wait(ex->epoll_fd, events, EPOLL_BATCH, -1);
+        if (n == -1) {
+            if (errno == EINTR) continue;
+            return fail_executor(ex, "epoll_wait: %s", strerror(errno));
+        }
+
+        int found = 0, failed = 0;
+        for (int i = 0; i < n; i++) {
+            uint64_t event = events[i].data.u64;
+            handle_t p = event >> 1;
+            if (event == wanted) found = 1;
+            else if (event == PIDFD_EVENT(wanted_process) && !(wanted & 1)) failed = 1;
+            else if (event & 1) mark_exited(ex, p);
+        }
+        if (found) return 1;
+        if (failed) return 0;
+    }
+}
+
+/* Spawns a process' child and waits for it to report that it runs, returns 0 if it does not */
+static int start_child(executor_t *ex, process_table_t *table, handle_t p) {
+    int ready[2];
+    if (pipe(ready) == -1) return fail_executor(ex, "pipe: %s", strerror(errno));
+    fcntl(ready[0], F_SETFD, FD_CLOEXEC);
+    fcntl(ready[1], F_SETFD, FD_CLOEXEC);
+    // dup2 onto itself would leave the write end close on exec
+    if (ready[1] == WORKLOAD_READY_FD) {
+        int fd = fcntl(ready[1], F_DUPFD_CLOEXEC, WORKLOAD_READY_FD + 1);
+        close(ready[1]);
+        ready[1] = fd;
+    }
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, ready[1], WORKLOAD_READY_FD);
+
+    char name[64];
+    int name_length = table->name_length[p] < 63 ? table->name_length[p] : 63;
+    memcpy(name, process_name(table, p), name_length);
+    name[name_length] = '\0';
+    char *argv[] = { (char *)ex->workload, name, NULL };
+
+    uint64_t start = now_ns();
+    int error = posix_spawn(&ex->pid[p], ex->workload, &actions, NULL, argv, environ);
+    posix_spawn_file_actions_destroy(&actions);
+    close(ready[1]);
+    if (error) {
+        ex->pid[p] = 0;
+        close(ready[0]);
+        return fail_executor(ex, "Cannot run workload %s: %s", ex->workload, strerror(error));
+    }
+
+    // the child is reaped by free_executor whichever way starting it fails from here on
+    ex->pidfd[p] = syscall(SYS_pidfd_open, ex->pid[p], 0);
+    struct epoll_event event = { .events = EPOLLIN };
+    event.data.u64 = PIDFD_EVENT(p);
+    int started = ex->pidfd[p] != -1 && epoll_ctl(ex->epoll_fd, EPOLL_CTL_ADD, ex->pidfd[p], &event) != -1;
+    event.data.u64 = READY_EVENT(p);
+    started = started && epoll_ctl(ex->epoll_fd, EPOLL_CTL_ADD, ready[0], &event) != -1;
+    if (!started) fail_executor(ex, "Cannot wait for workload %s: %s", ex->workload, strerror(errno));
+
+    if (started && !wait_for_event(ex, READY_EVENT(p))) {
+        started = fail_executor(ex, "Workload %s exited without starting", ex->workload);
+    }
+    if (started) record_latency(&ex->dispatch, start);
+
+    epoll_ctl(ex->epoll_fd, EPOLL_CTL_DEL, ready[0], NULL);
+    close(ready[0]);
+    return started;
+}
+
+/* Sends a stop or continue signal and waits for the child to change state, 0 if it has died */
+static int signal_child(executor_t *ex, handle_t p, int signal, int state) {
+    siginfo_t info;
+
+    if (ex->exited[p]) return 0;
+    kill(ex->pid[p], signal);
+
+    for (;;) {
+        memset(&info, 0, sizeof(info));
+        if (waitid(P_PIDFD, ex->pidfd[p], &info, state | WEXITED | WNOWAIT) == -1) {
+            if (errno == EINTR) continue;
+            return fail_executor(ex, "waitid: %s", strerror(errno));
+        }
+        if (info.si_code == CLD_EXITED || info.si_code == CLD_KILLED || info.si_code == CLD_DUMPED) {
+            mark_exited(ex, p);
+            return 0;
+        }
+        // consume the state change so the next one is seen
+        waitid(P_PIDFD, ex->pidfd[p], &info, state);
+        return 1;
+    }
+}
+
+/* Puts p's child on a CPU, stopping the child of the process it replaces first. Does nothing
+   once the executor has failed */
+void executor_run(executor_t *ex, process_table_t *table, handle_t p, handle_t switched_out) {
+    if (ex->error[0]) return;
+    if (p >= ex->capacity) grow_executor(ex, table->capacity);
+
+    uint64_t start = now_ns();
+    if (switched_out != NO_PROCESS && ex->pid[switched_out]) {
+        signal_child(ex, switched_out, SIGSTOP, WSTOPPED);
+    }
+
+    if (!ex->pid[p]) {
+        if (!start_child(ex, table, p)) return;
+    } else {
+        uint64_t resume = now_ns();
+        if (signal_child(ex, p, SIGCONT, WCONTINUED)) record_latency(&ex->dispatch, resume);
+    }
+
+    if (switched_out != NO_PROCESS) record_latency(&ex->context_switch, start);
+}
+
+/* Kills a finished process' child and reaps it once epoll reports its exit */
+void executor_finish(executor_t *ex, handle_t p) {
+    siginfo_t info;
+
+    if (p >= ex->capacity || !ex->pid[p]) return;
+
+    if (!ex->exited[p]) {
+        kill(ex->pid[p], SIGKILL);
+        wait_for_event(ex, PIDFD_EVENT(p));
+        epoll_ctl(ex->epoll_fd, EPOLL_CTL_DEL, ex->pidfd[p], NULL);
+    }
+    waitid(P_PIDFD, ex->pidfd[p], &info, WEXITED);
+    close(ex->pidfd[p]);
+
+    ex->pid[p] = 0;
+    ex->pidfd[p] = -1;
+    ex->exited[p] = 0;
+}
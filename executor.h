@@ -0,0 +1,63 @@
+#ifndef _EXECUTOR_H_
+#define _EXECUTOR_H_
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<stdarg.h>
+#include<stdint.h>
+#include<string.h>
+#include<errno.h>
+#include<assert.h>
+#include<signal.h>
+#include<spawn.h>
+#include<fcntl.h>
+#include<time.h>
+#include<unistd.h>
+#include<sys/epoll.h>
+#include<sys/syscall.h>
+#include<sys/wait.h>
+#include"queues.h"
+
+#ifndef P_PIDFD
+#define P_PIDFD 3
+#endif
+
+#define WORKLOAD_PATH "./workload"
+#define WORKLOAD_READY_FD 3     // the workload writes a byte to it once it has started
+#define EXECUTOR_ERROR_BYTES 256
+
+typedef struct {
+    uint64_t count;
+    uint64_t total_ns;
+    uint64_t max_ns;
+} latency_t;
+
+// Real execution backend. Every simulated process is backed by a child running the workload:
+// started when it first runs, stopped with SIGSTOP when switched out, continued with SIGCONT
+// when it runs again and killed and reaped when it finishes. Child exits are observed through
+// pidfds in an epoll set rather than by polling
+typedef struct {
+    const char *workload;
+    int epoll_fd;
+
+    // by process handle, grown with the process table
+    pid_t *pid;                 // 0 until the process first runs
+    int *pidfd;
+    uint8_t *exited;            // died before the simulation finished it
+    uint32_t capacity;
+
+    latency_t dispatch;         // from spawn or SIGCONT until the child is running
+    latency_t context_switch;   // from SIGSTOP of the outgoing child until the incoming one runs
+    int unexpected_exits;       // children that died before the simulation finished their process
+
+    // empty until a child cannot be run or waited for, the executor then does nothing more
+    char error[EXECUTOR_ERROR_BYTES];
+} executor_t;
+
+executor_t* make_executor(const char *workload);
+void free_executor(executor_t *ex);
+void executor_run(executor_t *ex, process_table_t *table, handle_t p, handle_t switched_out);
+void executor_finish(executor_t *ex, handle_t p);
+const char* executor_error(executor_t *ex);
+
+#endif
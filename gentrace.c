@@ -0,0 +1,123 @@
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<stdint.h>
+#include<math.h>
+#include<unistd.h>
+
+// Writes a synthetic input file for allocate, the same seed always gives the same trace
+// usage: ./gentrace -n <processes> [-S seed] [-a poisson|uniform|burst] [-g mean gap]
+//            [-b burst size] [-s exponential|uniform|pareto] [-t mean service time]
+//            [-d uniform|pow2] [-M max memory MB] > trace.txt
+
+#define POISSON 0
+#define UNIFORM 1
+#define BURST 2
+#define EXPONENTIAL 3
+#define PARETO 4
+#define POW2 5
+
+#define PARETO_SHAPE 1.5
+
+typedef struct {
+    uint64_t state;
+} rng_t;
+
+/* splitmix64, so traces do not depend on the C library's rand() */
+static uint64_t next_random(rng_t *rng) {
+    uint64_t z = (rng->state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// uniform in (0, 1]
+static double next_unit(rng_t *rng) {
+    return ((next_random(rng) >> 11) + 1) * (1.0 / 9007199254740992.0);
+}
+
+// uniform in [low, high]
+static long next_between(rng_t *rng, long low, long high) {
+    return low + (long)(next_random(rng) % (uint64_t)(high - low + 1));
+}
+
+/* Draws a value with the given distribution and mean */
+static long next_value(rng_t *rng, int distribution, double mean) {
+    switch (distribution) {
+        case EXPONENTIAL:
+        case POISSON:
+            return lround(-mean * log(next_unit(rng)));
+        case PARETO:
+            // scale chosen so the mean comes out as requested
+            return lround(mean * (PARETO_SHAPE - 1) / PARETO_SHAPE / pow(next_unit(rng), 1 / PARETO_SHAPE));
+        default:
+            return next_between(rng, 0, lround(2 * mean));
+    }
+}
+
+static int parse_distribution(char *name) {
+    if (strcmp(name, "poisson") == 0) return POISSON;
+    if (strcmp(name, "uniform") == 0) return UNIFORM;
+    if (strcmp(name, "burst") == 0) return BURST;
+    if (strcmp(name, "exponential") == 0) return EXPONENTIAL;
+    if (strcmp(name, "pareto") == 0) return PARETO;
+    if (strcmp(name, "pow2") == 0) return POW2;
+    fprintf(stderr, "Unknown distribution %s\n", name);
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char *argv[]) {
+    long processes = -1, burst_size = 8, max_memory = 512;
+    double mean_gap = 10, mean_service = 8;
+    int arrivals = POISSON, services = EXPONENTIAL, memory = UNIFORM, opt;
+    rng_t rng = { 1 };
+
+    while ((opt = getopt(argc, argv, "n:S:a:g:b:s:t:d:M:")) != -1) {
+        switch (opt) {
+            case 'n': processes = atol(optarg); break;
+            case 'S': rng.state = strtoull(optarg, NULL, 10); break;
+            case 'a': arrivals = parse_distribution(optarg); break;
+            case 'g': mean_gap = atof(optarg); break;
+            case 'b': burst_size = atol(optarg); break;
+            case 's': services = parse_distribution(optarg); break;
+            case 't': mean_service = atof(optarg); break;
+            case 'd': memory = parse_distribution(optarg); break;
+            case 'M': max_memory = atol(optarg); break;
+            default:
+                fprintf(stderr, "Missing argument\n");
+                exit(EXIT_FAILURE);
+        }
+    }
+    if (processes < 0 || burst_size < 1 || max_memory < 1) {
+        fprintf(stderr, "usage: %s -n <processes> [-S seed] [options]\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    static char buffer[1 << 20];
+    setvbuf(stdout, buffer, _IOFBF, sizeof(buffer));
+
+    long time = 0;
+    for (long i = 0; i < processes; i++) {
+        if (i > 0) {
+            if (arrivals != BURST) time += next_value(&rng, arrivals, mean_gap);
+            // a burst arrives at once, the gaps between bursts keep the same mean rate
+            else if (i % burst_size == 0) time += next_value(&rng, POISSON, mean_gap * burst_size);
+        }
+
+        long service_time = next_value(&rng, services, mean_service);
+        if (service_time < 1) service_time = 1;
+
+        long memory_requirement;
+        if (memory == POW2) {
+            int orders = 0;
+            while ((2L << orders) <= max_memory) orders++;
+            memory_requirement = 1L << next_between(&rng, 0, orders);
+        } else {
+            memory_requirement = next_between(&rng, 1, max_memory);
+        }
+
+        printf("%ld P%ld %ld %ld\n", time, i, service_time, memory_requirement);
+    }
+
+    return 0;
+}
@@ -0,0 +1,81 @@
+#include"heap.h"
+
+#define HEAP_INITIAL_CAPACITY 64
+
+static int entry_precedes(heap_entry_t *a, heap_entry_t *b) {
+    if (a->service_time != b->service_time) return a->service_time < b->service_time;
+    return a->seq < b->seq;
+}
+
+heap_t* make_empty_heap() {
+    heap_t *h = malloc(sizeof(heap_t));
+    assert(h!=NULL);
+
+    h->capacity = HEAP_INITIAL_CAPACITY;
+    h->entries = malloc(h->capacity * sizeof(heap_entry_t));
+    assert(h->entries!=NULL);
+    h->count = 0;
+    h->next_seq = 0;
+
+    return h;
+}
+
+void free_heap(heap_t *h) {
+    free(h->entries);
+    h->entries = NULL;
+    free(h);
+}
+
+/* Inserts a process keyed on its service time, sifting it up from the last leaf */
+void heap_push_process(heap_t *h, handle_t p, int64_t service_time) {
+    assert(p!=NO_PROCESS);
+
+    if (h->count == h->capacity) {
+        h->capacity *= 2;
+        h->entries = realloc(h->entries, h->capacity * sizeof(heap_entry_t));
+        assert(h->entries!=NULL);
+    }
+
+    heap_entry_t e = { service_time, h->next_seq++, p };
+    int i = h->count++;
+
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (!entry_precedes(&e, &h->entries[parent])) break;
+        h->entries[i] = h->entries[parent];
+        i = parent;
+    }
+    h->entries[i] = e;
+}
+
+/* Removes the process with the shortest service time, sifting the last leaf down from the root */
+handle_t heap_pop_process(heap_t *h) {
+    if (h->count == 0) return NO_PROCESS;
+
+    handle_t p = h->entries[0].p;
+    heap_entry_t last = h->entries[--h->count];
+    int i = 0;
+
+    while (1) {
+        int child = 2 * i + 1;
+        if (child >= h->count) break;
+        if (child + 1 < h->count && entry_precedes(&h->entries[child + 1], &h->entries[child])) {
+            child++;
+        }
+        if (!entry_precedes(&h->entries[child], &last)) break;
+        h->entries[i] = h->entries[child];
+        i = child;
+    }
+    if (h->count > 0) h->entries[i] = last;
+
+    return p;
+}
+
+/* The process heap_pop_process would take, NO_PROCESS if there is none */
+handle_t heap_peek_process(heap_t *h) {
+    return h->count ? h->entries[0].p : NO_PROCESS;
+}
+
+int heap_is_empty(heap_t *h) {
+    return h->count == 0;
+}
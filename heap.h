@@ -0,0 +1,30 @@
+#ifndef _HEAP_H_
+#define _HEAP_H_
+
+#include<stdlib.h>
+#include<stdint.h>
+#include<assert.h>
+#include"queues.h"
+
+typedef struct {
+    int64_t service_time;
+    uint64_t seq;       // insertion order, breaks service time ties first come first served
+    handle_t p;
+} heap_entry_t;
+
+// binary min heap keyed on (service_time, seq)
+typedef struct {
+    heap_entry_t *entries;
+    int count;
+    int capacity;
+    uint64_t next_seq;
+} heap_t;
+
+heap_t* make_empty_heap();
+void free_heap(heap_t *h);
+void heap_push_process(heap_t *h, handle_t p, int64_t service_time);
+handle_t heap_pop_process(heap_t *h);
+handle_t heap_peek_process(heap_t *h);
+int heap_is_empty(heap_t *h);
+
+#endif
@@ -0,0 +1,95 @@
+#include"histogram.h"
+
+const int percentiles[PERCENTILE_COUNT] = { 500, 950, 990, 999, 1000 };
+
+static const char *histogram_names[HISTOGRAM_COUNT] = {
+    [HISTOGRAM_TURNAROUND] = "turnaround",
+    [HISTOGRAM_WAIT] = "wait",
+    [HISTOGRAM_OVERHEAD] = "overhead",
+    [HISTOGRAM_ADMISSION] = "admission",
+};
+
+const char* histogram_name(int kind) {
+    return histogram_names[kind];
+}
+
+void init_histogram(histogram_t *h, int64_t scale) {
+    memset(h, 0, sizeof(histogram_t));
+    h->scale = scale;
+    h->min = INT64_MAX;
+}
+
+/* Bucket of a value, its top HISTOGRAM_SUB_BITS bits past the power of two it is in */
+static int bucket_index(int64_t value) {
+    if (value < HISTOGRAM_SUB_COUNT) return value;
+
+    int magnitude = 63 - __builtin_clzll(value) - (HISTOGRAM_SUB_BITS - 1);
+    int sub = value >> magnitude;
+    return HISTOGRAM_SUB_COUNT + (magnitude - 1) * HISTOGRAM_HALF_COUNT + sub - HISTOGRAM_HALF_COUNT;
+}
+
+/* Lowest value in a bucket */
+static int64_t bucket_low(int index) {
+    if (index < HISTOGRAM_SUB_COUNT) return index;
+
+    int magnitude = (index - HISTOGRAM_SUB_COUNT) / HISTOGRAM_HALF_COUNT + 1;
+    int sub = (index - HISTOGRAM_SUB_COUNT) % HISTOGRAM_HALF_COUNT + HISTOGRAM_HALF_COUNT;
+    return (int64_t)sub << magnitude;
+}
+
+static int64_t bucket_high(int index) {
+    if (index == HISTOGRAM_BUCKETS - 1) return INT64_MAX;
+    return bucket_low(index + 1) - 1;
+}
+
+/* Negative values are counted as 0 */
+void histogram_record(histogram_t *h, int64_t value) {
+    if (value < 0) value = 0;
+
+    h->counts[bucket_index(value)]++;
+    h->count++;
+    if (value < h->min) h->min = value;
+    if (value > h->max) h->max = value;
+}
+
+/* Adds the values of another histogram of the same scale, as if they had been recorded into it */
+void histogram_merge(histogram_t *into, const histogram_t *from) {
+    assert(into->scale == from->scale);
+
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++) into->counts[i] += from->counts[i];
+    into->count += from->count;
+    if (from->min < into->min) into->min = from->min;
+    if (from->max > into->max) into->max = from->max;
+}
+
+/* Highest value of the bucket the percentile falls in, no more than the largest value recorded.
+   0 when nothing has been recorded */
+int64_t histogram_percentile(const histogram_t *h, int tenths) {
+    if (h->count == 0) return 0;
+
+    uint64_t rank = (h->count * tenths + 999) / 1000;
+    if (rank < 1) rank = 1;
+
+    uint64_t seen = 0;
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        seen += h->counts[i];
+        if (seen >= rank) return bucket_high(i) < h->max ? bucket_high(i) : h->max;
+    }
+    return h->max;
+}
+
+/* One line per bucket holding values, with its bounds in the unscaled unit */
+void write_histogram_csv(FILE *f, const char *name, const histogram_t *h) {
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        if (h->counts[i] == 0) continue;
+
+        int64_t low = bucket_low(i), high = bucket_high(i) < h->max ? bucket_high(i) : h->max;
+        if (h->scale > 1) {
+            fprintf(f, "%s,%.3f,%.3f,%llu\n", name, (double)low / h->scale, (double)high / h->scale,
+                (unsigned long long)h->counts[i]);
+        } else {
+            fprintf(f, "%s,%lld,%lld,%llu\n", name, (long long)low, (long long)high,
+                (unsigned long long)h->counts[i]);
+        }
+    }
+}
@@ -0,0 +1,45 @@
+#ifndef _HISTOGRAM_H_
+#define _HISTOGRAM_H_
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<stdint.h>
+#include<assert.h>
+
+// Log-linear buckets in the manner of HDR histograms. Values below 128 have a bucket each, above
+// that every power of two is split into 64 buckets, so a value is known to within 1/64 of itself
+// and the memory taken does not depend on how many values are recorded
+#define HISTOGRAM_SUB_BITS 7
+#define HISTOGRAM_SUB_COUNT (1 << HISTOGRAM_SUB_BITS)
+#define HISTOGRAM_HALF_COUNT (HISTOGRAM_SUB_COUNT / 2)
+#define HISTOGRAM_BUCKETS (HISTOGRAM_SUB_COUNT + (63 - HISTOGRAM_SUB_BITS) * HISTOGRAM_HALF_COUNT)
+
+#define HISTOGRAM_TURNAROUND 0
+#define HISTOGRAM_WAIT 1
+#define HISTOGRAM_OVERHEAD 2
+#define HISTOGRAM_ADMISSION 3      // time spent in the input queue
+#define HISTOGRAM_COUNT 4
+
+#define HISTOGRAM_OVERHEAD_SCALE 1000
+
+// percentiles printed, in tenths of a percent
+#define PERCENTILE_COUNT 5
+extern const int percentiles[PERCENTILE_COUNT];
+
+typedef struct {
+    int64_t scale;              // recorded values are multiplied by it, so fractions keep digits
+    uint64_t count;
+    int64_t min;
+    int64_t max;
+    uint64_t counts[HISTOGRAM_BUCKETS];
+} histogram_t;
+
+const char* histogram_name(int kind);
+void init_histogram(histogram_t *h, int64_t scale);
+void histogram_record(histogram_t *h, int64_t value);
+void histogram_merge(histogram_t *into, const histogram_t *from);
+int64_t histogram_percentile(const histogram_t *h, int tenths);
+void write_histogram_csv(FILE *f, const char *name, const histogram_t *h);
+
+#endif
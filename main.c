@@ -0,0 +1,355 @@
+#include<getopt.h>
+#include "allocate.h"
+#include "sweep.h"
+#include "checkpoint.h"
+
+#define OPT_STATS 256
+#define OPT_MLFQ_LEVELS 257
+#define OPT_MLFQ_SLICES 258
+#define OPT_MLFQ_BOOST 259
+#define OPT_CHECKPOINT_AT 260
+#define OPT_RESTORE 261
+#define OPT_WORKLOAD 262
+#define OPT_MEMORY 263
+#define OPT_GRANULARITY 264
+#define OPT_COMPACT 265
+#define OPT_ADMISSION 266
+#define OPT_PERCENTILES 267
+#define OPT_HISTOGRAM_CSV 268
+
+int main (int argc, char *argv[]) {
+    int opt, sweep = 0, threads = 0, output_format = TEXT, execute = 0;
+    char *filename = NULL, *stats_filename = NULL;
+    char *checkpoint_filename = NULL, *restore_filename = NULL, *histogram_filename = NULL;
+    char *workload = WORKLOAD_PATH;
+    int64_t checkpoint_at = 0;
+    char *strategies = NULL, *memory_strategies = NULL, *quanta = NULL, *memory_sizes = NULL;
+    char *compaction = NULL, *admission = NULL;
+    char *fixed_option = NULL;      // the last option given that a restored run cannot change
+    config_t config = { SJF, INFINITE, 0, EVENT, MEMORY_MB, MEMORY_GRANULARITY, 1 };
+
+    static struct option long_options[] = {
+        { "stats", required_argument, NULL, OPT_STATS },
+        { "mlfq-levels", required_argument, NULL, OPT_MLFQ_LEVELS },
+        { "mlfq-slices", required_argument, NULL, OPT_MLFQ_SLICES },
+        { "mlfq-boost", required_argument, NULL, OPT_MLFQ_BOOST },
+        { "checkpoint-at", required_argument, NULL, OPT_CHECKPOINT_AT },
+        { "restore", required_argument, NULL, OPT_RESTORE },
+        { "workload", required_argument, NULL, OPT_WORKLOAD },
+        { "memory", required_argument, NULL, OPT_MEMORY },
+        { "granularity", required_argument, NULL, OPT_GRANULARITY },
+        { "compact", required_argument, NULL, OPT_COMPACT },
+        { "admission", required_argument, NULL, OPT_ADMISSION },
+        { "percentiles", no_argument, NULL, OPT_PERCENTILES },
+        { "histogram-csv", required_argument, NULL, OPT_HISTOGRAM_CSV },
+        { NULL, 0, NULL, 0 }
+    };
+
+    while ((opt = getopt_long(argc, argv, "f:s:m:q:a:o:M:c:wj:x", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 'f': // input file, - for stdin
+                filename = optarg;
+                break;
+            case 's': // strategy
+                // SJF, RR or MLFQ
+                strategies = optarg;
+                config.strategy = parse_scheduler(optarg);
+                fixed_option = "-s";
+                break;
+            case 'm': // allocate memory
+                // infinite, best-fit, first-fit, next-fit, worst-fit, buddy, paged or virtual
+                memory_strategies = optarg;
+                config.memory_strategy = parse_memory_strategy(optarg);
+                break;
+            case 'q': // quantum
+                quanta = optarg;
+                config.quantum = atoi(optarg);
+                break;
+            case 'a': // time advance
+                // event skips cycles in which nothing can happen, tick runs every quantum
+                if (strcmp(optarg, "tick") == 0) config.time_advance = TICK;
+                break;
+            case 'o': // output format
+                // binary writes a fixed-width event log, see decode.c
+                if (strcmp(optarg, "binary") == 0) output_format = BINARY;
+                break;
+            case 'M': // memory size, in MB unless it has a K, G or T suffix
+            case OPT_MEMORY:
+                memory_sizes = optarg;
+                fixed_option = "-M";
+                break;
+            case OPT_GRANULARITY: { // allocation unit, a power of two such as 4K
+                int64_t bytes = parse_memory_size(optarg);
+                if (bytes < MIN_GRANULARITY || (bytes & (bytes - 1))) {
+                    fprintf(stderr, "Granularity must be a power of two of at least 4K\n");
+                    exit(EXIT_FAILURE);
+                }
+                config.granularity = bytes;
+                fixed_option = "--granularity";
+                break;
+            }
+            case OPT_COMPACT: { // compact memory when fragmentation keeps a process out, at a time per MB moved
+                char *end;
+                config.compaction_cost = strtod(optarg, &end);
+                if (end == optarg || *end != '\0' || !(config.compaction_cost >= 0)) {
+                    fprintf(stderr, "Compaction cost must be a time per MB of at least 0\n");
+                    exit(EXIT_FAILURE);
+                }
+                config.compaction = 1;
+                compaction = optarg;
+                break;
+            }
+            case OPT_ADMISSION: // greedy admits whatever fits, backfill keeps a reservation for the first left out
+                if (strcmp(optarg, "backfill") == 0) config.admission = BACKFILL;
+                else if (strcmp(optarg, "greedy") == 0) config.admission = GREEDY;
+                else {
+                    fprintf(stderr, "Unknown admission policy %s\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                admission = optarg;
+                break;
+            case OPT_PERCENTILES: // turnaround, wait, overhead and admission delay percentiles
+                config.histograms = 1;
+                break;
+            case OPT_HISTOGRAM_CSV: // the histograms behind the percentiles, - for stderr
+                config.histograms = 1;
+                histogram_filename = optarg;
+                break;
+            case 'c': // number of CPUs
+                config.cpus = atoi(optarg);
+                if (config.cpus < 1 || config.cpus > MAX_CPUS) {
+                    fprintf(stderr, "Number of CPUs must be between 1 and %d\n", MAX_CPUS);
+                    exit(EXIT_FAILURE);
+                }
+                fixed_option = "-c";
+                break;
+            case 'w': // sweep, -s -m -q -M take comma separated lists
+                sweep = 1;
+                break;
+            case 'j': // sweep worker threads
+                threads = atoi(optarg);
+                break;
+            case OPT_MLFQ_LEVELS: // number of MLFQ priority levels
+                config.mlfq_levels = atoi(optarg);
+                if (config.mlfq_levels < 1 || config.mlfq_levels > MLFQ_MAX_LEVELS) {
+                    fprintf(stderr, "Number of MLFQ levels must be between 1 and %d\n", MLFQ_MAX_LEVELS);
+                    exit(EXIT_FAILURE);
+                }
+                fixed_option = "--mlfq-levels";
+                break;
+            case OPT_MLFQ_SLICES: { // comma separated time slice of each level, from the highest
+                int level = 0;
+                for (char *slice = strtok(optarg, ","); slice && level < MLFQ_MAX_LEVELS; slice = strtok(NULL, ",")) {
+                    config.mlfq_slices[level++] = atoll(slice);
+                }
+                fixed_option = "--mlfq-slices";
+                break;
+            }
+            case OPT_MLFQ_BOOST: // time between MLFQ boosts
+                config.mlfq_boost = atoll(optarg);
+                fixed_option = "--mlfq-boost";
+                break;
+            case 'x': // really run every process as a child running the workload
+                execute = 1;
+                break;
+            case OPT_WORKLOAD: // program the children of -x run
+                workload = optarg;
+                break;
+            case OPT_CHECKPOINT_AT: // time, then the file the state of the run is saved to at that time
+                if (optind >= argc) {
+                    fprintf(stderr, "--checkpoint-at needs a time and a file\n");
+                    exit(EXIT_FAILURE);
+                }
+                checkpoint_at = atoll(optarg);
+                checkpoint_filename = argv[optind++];
+                break;
+            case OPT_RESTORE: // continue a run from a checkpoint, reading the rest of the same trace
+                restore_filename = optarg;
+                break;
+            case OPT_STATS: // JSON counters and timers, - for stderr
+                if (!STATS_ENABLED) {
+                    fprintf(stderr, "--stats needs a build with make STATS=1\n");
+                    exit(EXIT_FAILURE);
+                }
+                stats_filename = optarg;
+                break;
+            default:
+                fprintf(stderr, "Missing argument\n");
+                exit(EXIT_FAILURE);
+        }
+    } 
+
+    if (!sweep && config.strategy < 0) {
+        fprintf(stderr, "Unknown scheduler %s\n", strategies);
+        exit(EXIT_FAILURE);
+    }
+    if (!sweep && config.memory_strategy < 0) {
+        fprintf(stderr, "Unknown memory strategy %s\n", memory_strategies);
+        exit(EXIT_FAILURE);
+    }
+    // a restored run keeps the saved quantum unless -q changes it
+    if (!sweep && (quanta || !restore_filename) && config.quantum < 1) {
+        fprintf(stderr, "Quantum must be at least 1\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // a sweep parses its own comma separated list of sizes
+    if (!sweep && memory_sizes) {
+        int64_t bytes = parse_memory_size(memory_sizes);
+        if (bytes < ((int64_t)1 << 20) || bytes % ((int64_t)1 << 20)) {
+            fprintf(stderr, "Memory size must be a whole number of MB, up to an EB\n");
+            exit(EXIT_FAILURE);
+        }
+        config.memory_mb = bytes >> 20;
+    }
+    if (!sweep && allocator_pages(config.memory_strategy) && config.memory_mb > MAX_PAGED_MEMORY_MB) {
+        fprintf(stderr, "Paged memory can be at most %lldMB\n", (long long)MAX_PAGED_MEMORY_MB);
+        exit(EXIT_FAILURE);
+    }
+    if (!sweep && config.granularity > config.memory_mb << 20) {
+        fprintf(stderr, "Granularity cannot be larger than the memory\n");
+        exit(EXIT_FAILURE);
+    }
+    // the allocators count memory in whole allocation units, a part unit would be lost
+    if (!sweep && (config.memory_mb << 20) % config.granularity) {
+        fprintf(stderr, "Memory size must be a multiple of the granularity\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (sweep && (checkpoint_filename || restore_filename)) {
+        fprintf(stderr, "Checkpoints cannot be taken or restored in a sweep\n");
+        exit(EXIT_FAILURE);
+    }
+    if (sweep && config.histograms) {
+        fprintf(stderr, "Percentiles are not kept in a sweep\n");
+        exit(EXIT_FAILURE);
+    }
+    if (sweep && execute) {
+        fprintf(stderr, "Processes cannot be executed in a sweep\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (sweep) {
+        return run_sweep(filename, strategies, memory_strategies, quanta, memory_sizes, 
+            &config, threads);
+    }
+
+    // a restored run takes its configuration from the checkpoint, except that the quantum, the
+    // compaction, the admission policy and, among the segment list strategies, the memory strategy
+    // may change to try what-ifs. The rest cannot, and giving them is an error rather than ignored
+    checkpoint_t *checkpoint = NULL;
+    if (restore_filename && fixed_option) {
+        fprintf(stderr, "%s cannot be changed in a restored run\n", fixed_option);
+        exit(EXIT_FAILURE);
+    }
+    if (restore_filename) {
+        checkpoint = open_checkpoint(restore_filename);
+        if (checkpoint == NULL) {
+            fprintf(stderr, "Checkpoint file error\n");
+            exit(EXIT_FAILURE);
+        }
+        config_t saved = checkpoint->config;
+        if (memory_strategies) {
+            if (!allocators_share_state(config.memory_strategy, saved.memory_strategy)) {
+                fprintf(stderr, "Checkpoint memory cannot be restored as %s\n", memory_strategies);
+                exit(EXIT_FAILURE);
+            }
+            saved.memory_strategy = config.memory_strategy;
+        }
+        if (quanta) saved.quantum = config.quantum;
+        if (compaction) {
+            saved.compaction = config.compaction;
+            saved.compaction_cost = config.compaction_cost;
+        }
+        if (admission) saved.admission = config.admission;
+        saved.histograms = config.histograms;
+        saved.time_advance = config.time_advance;
+        config = saved;
+    }
+
+    // only the segment lists can move blocks, a sweep just leaves compaction off for the others
+    if (config.compaction && !allocator_can_compact(config.memory_strategy)) {
+        fprintf(stderr, "Compaction needs best-fit, first-fit, next-fit or worst-fit memory\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (config.admission == BACKFILL && config.memory_strategy == INFINITE) {
+        fprintf(stderr, "Backfilling needs finite memory\n");
+        exit(EXIT_FAILURE);
+    }
+
+    writer_t *out = make_writer(STDOUT_FILENO, output_format, config.cpus);
+    simulation_t *sim = make_simulation(&config, out);
+    sim->checkpoint_file = checkpoint_filename;
+    sim->checkpoint_at = checkpoint_at;
+    if (execute) sim->executor = make_executor(workload);
+
+    // the saved processes take their handles before the trace reads any
+    if (checkpoint && restore_checkpoint(sim, checkpoint) != 0) {
+        fprintf(stderr, "Checkpoint file error\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // processes are read from the trace as their arrival time is reached
+    sim->trace = filename ? open_trace(filename, sim->processes, sim->name_arena) : NULL;
+    if (sim->trace == NULL) {
+        fprintf(stderr, "Input file error\n");
+        exit(EXIT_FAILURE);
+    }
+    if (trace_error(sim->trace)) {
+        fprintf(stderr, "%s\n", trace_error(sim->trace));
+        exit(EXIT_FAILURE);
+    }
+    if (checkpoint) {
+        if (skip_checkpoint_trace(sim, checkpoint) != 0) {
+            fprintf(stderr, "Checkpoint was not taken from %s\n", filename);
+            exit(EXIT_FAILURE);
+        }
+        close_checkpoint(checkpoint);
+    }
+
+    if (schedule_processes(sim) != 0) {
+        flush_writer(out);
+        fprintf(stderr, "%s\n", sim->error);
+        exit(EXIT_FAILURE);
+    }
+    if (trace_was_sorted(sim->trace)) {
+        fprintf(stderr, "Input not sorted by arrival time, the processes were sorted\n");
+    }
+    if (sim->checkpoint_file) {
+        fprintf(stderr, "Run finished before time %lld, no checkpoint written\n", (long long)checkpoint_at);
+    }
+    if (sim->executor && sim->executor->unexpected_exits) {
+        fprintf(stderr, "%d workloads exited before their process finished\n", sim->executor->unexpected_exits);
+    }
+
+    if (stats_filename && sim->stats) {
+        FILE *f = strcmp(stats_filename, "-") == 0 ? stderr : fopen(stats_filename, "w");
+        if (f == NULL) {
+            fprintf(stderr, "Stats file error\n");
+            exit(EXIT_FAILURE);
+        }
+        write_stats_json(f, sim->stats);
+        if (f != stderr) fclose(f);
+    }
+
+    if (histogram_filename) {
+        FILE *f = strcmp(histogram_filename, "-") == 0 ? stderr : fopen(histogram_filename, "w");
+        if (f == NULL) {
+            fprintf(stderr, "Histogram file error\n");
+            exit(EXIT_FAILURE);
+        }
+        fprintf(f, "histogram,low,high,count\n");
+        for (int i = 0; i < HISTOGRAM_COUNT; i++) write_histogram_csv(f, histogram_name(i), &sim->histograms[i]);
+        if (f != stderr) fclose(f);
+    }
+
+    free_simulation(sim);
+    if (flush_writer(out) != 0) {
+        fprintf(stderr, "write: %s\n", strerror(out->error));
+        exit(EXIT_FAILURE);
+    }
+    free_writer(out);
+
+    return 0;
+}
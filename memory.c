@@ -0,0 +1,399 @@
+#include"memory.h"
+
+/* Creates an empty memory hole from 0 to memory_units */
+memory_t* initialize_simulated_memory(int64_t memory_units, stats_t *stats) {
+    memory_t *memory = malloc(sizeof(memory_t));
+    assert(memory!=NULL);
+    memory->holes = NULL;
+    memory->hole_count = 0;
+    memory->hole_memory = 0;
+    memory->stats = stats;
+    memory->segment_pool = make_pool(sizeof(segment_t));
+
+    memory->head = make_new_segment(memory, 0, memory_units);
+    memory->cursor = memory->head;
+    insert_hole(memory, memory->head);
+
+    return memory;
+}
+
+/* The segment a process table holds the index of */
+segment_t* memory_segment(memory_t *memory, uint32_t index) {
+    return pool_object(memory->segment_pool, index);
+}
+
+void free_simulated_memory(memory_t *memory) {
+    free_pool(memory->segment_pool);
+    free(memory);
+}
+
+/* Creates a new memory segment to fit a process into */
+segment_t *make_new_segment(memory_t *memory, int64_t from, int64_t to) {
+    uint32_t index;
+    segment_t *s = pool_alloc(memory->segment_pool, &index);
+
+    s->index = index;
+    s->mem_start = from;
+    s->mem_end = to;
+    s->process = NO_PROCESS;
+    s->next_s = NULL;
+    s->prev_s = NULL;
+    s->hole_left = NULL;
+    s->hole_right = NULL;
+    s->hole_height = 0;
+
+    return s;
+}
+
+int64_t segment_available_memory(segment_t *curr) {
+    return curr->mem_end - curr->mem_start + 1;
+}
+
+/* Smallest hole that can hold the requirement, the lowest addressed one among equal sizes */
+segment_t* find_best_fit_hole(memory_t *memory, int64_t memory_requirement) {
+    segment_t *curr = memory->holes, *best_fit_segment = NULL;
+    STAT_DECLARE(uint64_t scanned = 0);
+
+    while (curr) {
+        STAT_ONLY(scanned++);
+        if (segment_available_memory(curr) >= memory_requirement) {
+            best_fit_segment = curr;
+            curr = curr->hole_left;
+        } else {
+            curr = curr->hole_right;
+        }
+    }
+
+    STAT_ADD(memory->stats, hole_searches, 1);
+    STAT_ADD(memory->stats, segments_scanned, scanned);
+    STAT_MAX(memory->stats, max_segments_scanned, scanned);
+
+    return best_fit_segment;
+}
+
+/* Lowest addressed hole that can hold the requirement */
+segment_t* find_first_fit_hole(memory_t *memory, int64_t memory_requirement) {
+    segment_t *curr = memory->head;
+    STAT_DECLARE(uint64_t scanned = 0);
+
+    while (curr && (curr->process != NO_PROCESS || segment_available_memory(curr) < memory_requirement)) {
+        STAT_ONLY(scanned++);
+        curr = curr->next_s;
+    }
+
+    STAT_ADD(memory->stats, hole_searches, 1);
+    STAT_ADD(memory->stats, segments_scanned, scanned + 1);
+    STAT_MAX(memory->stats, max_segments_scanned, scanned + 1);
+
+    return curr;
+}
+
+/* First hole that can hold the requirement, searching on from the last one handed out
+   and wrapping around to the start of memory */
+segment_t* find_next_fit_hole(memory_t *memory, int64_t memory_requirement) {
+    segment_t *start = memory->cursor, *curr = start;
+    STAT_DECLARE(uint64_t scanned = 0);
+
+    do {
+        STAT_ONLY(scanned++);
+        if (curr->process == NO_PROCESS && segment_available_memory(curr) >= memory_requirement) break;
+        curr = curr->next_s ? curr->next_s : memory->head;
+    } while (curr != start);
+
+    STAT_ADD(memory->stats, hole_searches, 1);
+    STAT_ADD(memory->stats, segments_scanned, scanned);
+    STAT_MAX(memory->stats, max_segments_scanned, scanned);
+
+    if (curr->process != NO_PROCESS || segment_available_memory(curr) < memory_requirement) return NULL;
+    memory->cursor = curr;
+    return curr;
+}
+
+/* Largest hole, the lowest addressed one among equal sizes */
+segment_t* find_worst_fit_hole(memory_t *memory, int64_t memory_requirement) {
+    int64_t largest = largest_hole(memory);
+    if (largest < memory_requirement) {
+        STAT_ADD(memory->stats, hole_searches, 1);
+        return NULL;
+    }
+
+    return find_best_fit_hole(memory, largest);
+}
+
+/* Size of the largest hole, the rightmost one in the index */
+int64_t largest_hole(memory_t *memory) {
+    segment_t *curr = memory->holes;
+    if (!curr) return 0;
+
+    while (curr->hole_right) curr = curr->hole_right;
+    return segment_available_memory(curr);
+}
+
+/* Assigns a process to a hole, splitting off the memory it does not need as a new hole */
+void assign_hole(memory_t *memory, segment_t *hole, int64_t memory_requirement, handle_t p) {
+    remove_hole(memory, hole);
+
+    // Split memory segment to accomodate process
+    int64_t remaining_memory = hole->mem_end - memory_requirement;
+
+    // assumes process memory req <= best fit segment size
+    if (remaining_memory > 0) {
+        // hole reduces its size down to memory_requirement, and
+        // next will be inserted into linked list after hole
+        segment_t *next = make_new_segment(memory, hole->mem_start + memory_requirement, hole->mem_end);
+        // insertion into doubly linked list
+        hole->mem_end = hole->mem_start + memory_requirement - 1;
+        next->next_s = hole->next_s;
+        next->prev_s = hole;
+        if (hole->next_s) {
+            hole->next_s->prev_s = next;
+        }
+        hole->next_s = next;
+        insert_hole(memory, next);
+    }
+    // assign process to memory segment
+    hole->process = p;
+}
+
+/* Frees a finished process' block and merges it with the holes either side of it */
+void free_segment(memory_t *memory, segment_t *s) {
+    segment_t *prev = s->prev_s, *next = s->next_s;
+
+    s->process = NO_PROCESS;
+
+    // absorb the following hole
+    if (next && next->process == NO_PROCESS) {
+        remove_hole(memory, next);
+        if (memory->cursor == next) memory->cursor = s;
+        s->mem_end = next->mem_end;
+        s->next_s = next->next_s;
+        if (next->next_s) next->next_s->prev_s = s;
+        pool_free(memory->segment_pool, next->index);
+    }
+
+    // the preceding hole absorbs this block
+    if (prev && prev->process == NO_PROCESS) {
+        remove_hole(memory, prev);
+        if (memory->cursor == s) memory->cursor = prev;
+        prev->mem_end = s->mem_end;
+        prev->next_s = s->next_s;
+        if (s->next_s) s->next_s->prev_s = prev;
+        pool_free(memory->segment_pool, s->index);
+        s = prev;
+    }
+
+    insert_hole(memory, s);
+}
+
+/* Slides every block down to the lowest free address, in address order, leaving a single hole
+   at the top of memory. Returns the units moved */
+int64_t compact_memory(memory_t *memory) {
+    segment_t *s = memory->head, *last = NULL;
+    int64_t next_start = memory->head->mem_start, top = memory->head->mem_end, moved = 0;
+
+    memory->head = NULL;
+    while (s) {
+        segment_t *next = s->next_s;
+        top = s->mem_end;
+
+        if (s->process == NO_PROCESS) {
+            remove_hole(memory, s);
+            pool_free(memory->segment_pool, s->index);
+        } else {
+            int64_t size = s->mem_end - s->mem_start + 1;
+            if (s->mem_start != next_start) moved += size;
+            s->mem_start = next_start;
+            s->mem_end = next_start + size - 1;
+            next_start += size;
+
+            s->prev_s = last;
+            s->next_s = NULL;
+            if (last) last->next_s = s;
+            else memory->head = s;
+            last = s;
+        }
+        s = next;
+    }
+
+    memory->cursor = last;
+    if (next_start <= top) {
+        segment_t *hole = make_new_segment(memory, next_start, top);
+        hole->prev_s = last;
+        if (last) last->next_s = hole;
+        else memory->head = hole;
+        insert_hole(memory, hole);
+        memory->cursor = hole;
+    }
+
+    return moved;
+}
+
+/* Saves the segment list into buffer, returns the bytes it takes. A NULL buffer only sizes it */
+size_t checkpoint_memory(memory_t *memory, void *buffer) {
+    checkpoint_memory_t *header = buffer;
+    checkpoint_segment_t *segments = (checkpoint_segment_t *)(header + 1);
+    uint32_t count = 0;
+
+    for (segment_t *s = memory->head; s; s = s->next_s, count++) {
+        if (!buffer) continue;
+        if (s == memory->cursor) header->cursor = count;
+        segments[count].mem_start = s->mem_start;
+        segments[count].mem_end = s->mem_end;
+        segments[count].process = s->process;
+        segments[count].reserved = 0;
+    }
+    if (buffer) header->segment_count = count;
+
+    return sizeof(checkpoint_memory_t) + count * sizeof(checkpoint_segment_t);
+}
+
+/* Replaces the segment list with a saved one, pointing the processes in it at their segments.
+   Returns -1, leaving memory as it was, unless the saved segments cover the same memory */
+int restore_memory(memory_t *memory, process_table_t *table, const void *data, size_t length) {
+    const checkpoint_memory_t *header = data;
+    const checkpoint_segment_t *segments = (const checkpoint_segment_t *)(header + 1);
+    if (length < sizeof(checkpoint_memory_t) || header->segment_count == 0 || header->cursor >= header->segment_count
+        || (length - sizeof(checkpoint_memory_t)) / sizeof(checkpoint_segment_t) != header->segment_count
+        || (length - sizeof(checkpoint_memory_t)) % sizeof(checkpoint_segment_t)) {
+        return -1;
+    }
+    // memory is still the one hole it starts as. A hole split off by an exact fit may be empty
+    int64_t next_start = 0;
+    for (uint32_t i = 0; i < header->segment_count; i++) {
+        if (segments[i].mem_start != next_start || segments[i].mem_end < segments[i].mem_start - 1
+            || (segments[i].process != NO_PROCESS && segments[i].process >= table->capacity)) {
+            return -1;
+        }
+        next_start = segments[i].mem_end + 1;
+    }
+    if (next_start != memory->head->mem_end + 1) return -1;
+
+    // drop the initial hole
+    remove_hole(memory, memory->head);
+    pool_free(memory->segment_pool, memory->head->index);
+    memory->head = memory->cursor = NULL;
+
+    segment_t *prev = NULL;
+    for (uint32_t i = 0; i < header->segment_count; i++) {
+        segment_t *s = make_new_segment(memory, segments[i].mem_start, segments[i].mem_end);
+        s->process = segments[i].process;
+        s->prev_s = prev;
+        if (prev) prev->next_s = s;
+        else memory->head = s;
+
+        if (s->process == NO_PROCESS) insert_hole(memory, s);
+        else table->segment[s->process] = s->index;
+        if (i == header->cursor) memory->cursor = s;
+        prev = s;
+    }
+    return 0;
+}
+
+/* Free hole index */
+
+static int hole_height(segment_t *s) {
+    return s ? s->hole_height : 0;
+}
+
+static void update_hole_height(segment_t *s) {
+    int left = hole_height(s->hole_left), right = hole_height(s->hole_right);
+    s->hole_height = 1 + (left > right ? left : right);
+}
+
+/* Orders holes by size, then by address */
+static int hole_precedes(segment_t *a, segment_t *b) {
+    int64_t a_size = segment_available_memory(a), b_size = segment_available_memory(b);
+    if (a_size != b_size) return a_size < b_size;
+    return a->mem_start < b->mem_start;
+}
+
+static segment_t* rotate_hole_right(segment_t *s) {
+    segment_t *l = s->hole_left;
+    s->hole_left = l->hole_right;
+    l->hole_right = s;
+    update_hole_height(s);
+    update_hole_height(l);
+    return l;
+}
+
+static segment_t* rotate_hole_left(segment_t *s) {
+    segment_t *r = s->hole_right;
+    s->hole_right = r->hole_left;
+    r->hole_left = s;
+    update_hole_height(s);
+    update_hole_height(r);
+    return r;
+}
+
+static segment_t* rebalance_holes(segment_t *s) {
+    update_hole_height(s);
+    int balance = hole_height(s->hole_left) - hole_height(s->hole_right);
+
+    if (balance > 1) {
+        if (hole_height(s->hole_left->hole_left) < hole_height(s->hole_left->hole_right)) {
+            s->hole_left = rotate_hole_left(s->hole_left);
+        }
+        return rotate_hole_right(s);
+    }
+    if (balance < -1) {
+        if (hole_height(s->hole_right->hole_right) < hole_height(s->hole_right->hole_left)) {
+            s->hole_right = rotate_hole_right(s->hole_right);
+        }
+        return rotate_hole_left(s);
+    }
+    return s;
+}
+
+static segment_t* insert_hole_at(segment_t *root, segment_t *hole) {
+    if (!root) return hole;
+    if (hole_precedes(hole, root)) root->hole_left = insert_hole_at(root->hole_left, hole);
+    else root->hole_right = insert_hole_at(root->hole_right, hole);
+    return rebalance_holes(root);
+}
+
+/* Detaches the first hole in the subtree, storing it in *min */
+static segment_t* remove_first_hole(segment_t *root, segment_t **min) {
+    if (!root->hole_left) {
+        *min = root;
+        return root->hole_right;
+    }
+    root->hole_left = remove_first_hole(root->hole_left, min);
+    return rebalance_holes(root);
+}
+
+static segment_t* remove_hole_at(segment_t *root, segment_t *hole) {
+    assert(root!=NULL);
+
+    if (root != hole) {
+        if (hole_precedes(hole, root)) root->hole_left = remove_hole_at(root->hole_left, hole);
+        else root->hole_right = remove_hole_at(root->hole_right, hole);
+        return rebalance_holes(root);
+    }
+
+    segment_t *left = root->hole_left, *right = root->hole_right, *successor;
+    root->hole_left = root->hole_right = NULL;
+    root->hole_height = 0;
+
+    if (!right) return left;
+    right = remove_first_hole(right, &successor);
+    successor->hole_left = left;
+    successor->hole_right = right;
+    return rebalance_holes(successor);
+}
+
+/* Adds a hole to the index, must be called after its bounds are final */
+void insert_hole(memory_t *memory, segment_t *hole) {
+    hole->hole_left = hole->hole_right = NULL;
+    hole->hole_height = 1;
+    memory->holes = insert_hole_at(memory->holes, hole);
+    memory->hole_count++;
+    memory->hole_memory += segment_available_memory(hole);
+    STAT_MAX(memory->stats, max_holes, memory->hole_count);
+}
+
+/* Removes a hole from the index, must be called before its bounds change */
+void remove_hole(memory_t *memory, segment_t *hole) {
+    memory->holes = remove_hole_at(memory->holes, hole);
+    memory->hole_count--;
+    memory->hole_memory -= segment_available_memory(hole);
+}
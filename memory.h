@@ -0,0 +1,74 @@
+#ifndef _MEMORY_H_
+#define _MEMORY_H_
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<assert.h>
+#include<stdint.h>
+#include"queues.h"
+#include"stats.h"
+
+typedef struct segment segment_t;
+
+#define MEMORY_MB 2048
+
+// doubly linked list, bounds are in allocation units and inclusive
+struct segment {
+    int64_t mem_start;
+    int64_t mem_end;
+    segment_t *next_s;
+    segment_t *prev_s;
+    handle_t process;               // NO_PROCESS while the segment is a hole
+    uint32_t index;                 // in the segment pool, what the process table holds
+
+    // free hole index, an AVL tree keyed on (size, mem_start), only used while process is NO_PROCESS
+    segment_t *hole_left;
+    segment_t *hole_right;
+    int hole_height;
+};
+
+// simulated memory, segments in address order plus an index of its holes
+typedef struct {
+    segment_t *head;
+    segment_t *holes;
+    int hole_count;
+    int64_t hole_memory;        // units free across all holes
+    segment_t *cursor;          // next-fit resumes its search here
+    pool_t *segment_pool;
+    stats_t *stats;             // NULL unless built with STATS=1
+} memory_t;
+
+// a segment as saved in a checkpoint, in address order after a checkpoint_memory_t
+typedef struct {
+    int64_t mem_start;
+    int64_t mem_end;
+    uint32_t process;
+    uint32_t reserved;
+} checkpoint_segment_t;
+
+typedef struct {
+    uint32_t segment_count;
+    uint32_t cursor;            // index of the next-fit cursor's segment
+} checkpoint_memory_t;
+
+memory_t* initialize_simulated_memory(int64_t memory_units, stats_t *stats);
+void free_simulated_memory(memory_t *memory);
+segment_t *make_new_segment(memory_t *memory, int64_t from, int64_t to);
+segment_t* memory_segment(memory_t *memory, uint32_t index);
+int64_t segment_available_memory(segment_t *curr);
+segment_t* find_best_fit_hole(memory_t *memory, int64_t memory_requirement);
+segment_t* find_first_fit_hole(memory_t *memory, int64_t memory_requirement);
+segment_t* find_next_fit_hole(memory_t *memory, int64_t memory_requirement);
+segment_t* find_worst_fit_hole(memory_t *memory, int64_t memory_requirement);
+int64_t largest_hole(memory_t *memory);
+void assign_hole(memory_t *memory, segment_t *hole, int64_t memory_requirement, handle_t p);
+void free_segment(memory_t *memory, segment_t *s);
+int64_t compact_memory(memory_t *memory);
+size_t checkpoint_memory(memory_t *memory, void *buffer);
+int restore_memory(memory_t *memory, process_table_t *table, const void *data, size_t length);
+
+// Free hole index
+void insert_hole(memory_t *memory, segment_t *hole);
+void remove_hole(memory_t *memory, segment_t *hole);
+
+#endif
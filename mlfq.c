@@ -0,0 +1,116 @@
+#include"mlfq.h"
+
+mlfq_t* make_mlfq(int levels, int64_t *slices, process_table_t *table) {
+    mlfq_t *m = malloc(sizeof(mlfq_t));
+    assert(m!=NULL);
+    assert(levels >= 1 && levels <= MLFQ_MAX_LEVELS);
+
+    m->levels = levels;
+    m->bitmap = 0;
+    m->count = 0;
+    m->table = table;
+    for (int i = 0; i < levels; i++) {
+        m->slices[i] = slices[i];
+        m->queues[i] = make_empty_queue(table);
+    }
+
+    return m;
+}
+
+void free_mlfq(mlfq_t *m) {
+    for (int i = 0; i < m->levels; i++) free(m->queues[i]);
+    free(m);
+}
+
+/* Appends a process to the queue of its level */
+void mlfq_enqueue_process(mlfq_t *m, handle_t p) {
+    int level = m->table->level[p];
+
+    enqueue_process(m->queues[level], p);
+    m->bitmap |= (uint64_t)1 << level;
+    m->count++;
+}
+
+/* Takes the first process of the highest priority level that has one */
+handle_t mlfq_dequeue_process(mlfq_t *m) {
+    if (!m->bitmap) return NO_PROCESS;
+
+    int level = __builtin_ctzll(m->bitmap);
+    handle_t p = dequeue_process(m->queues[level]);
+    if (queue_is_empty(m->queues[level])) m->bitmap &= ~((uint64_t)1 << level);
+    m->count--;
+
+    return p;
+}
+
+/* The process mlfq_dequeue_process would take, NO_PROCESS if there is none */
+handle_t mlfq_peek_process(mlfq_t *m) {
+    if (!m->bitmap) return NO_PROCESS;
+    return m->queues[__builtin_ctzll(m->bitmap)]->head;
+}
+
+/* Highest priority level with a process waiting, levels if there is none */
+int mlfq_top_level(mlfq_t *m) {
+    if (!m->bitmap) return m->levels;
+    return __builtin_ctzll(m->bitmap);
+}
+
+/* Moves every waiting process up to the highest priority level with a fresh time slice,
+   keeping them in level order */
+void mlfq_boost(mlfq_t *m) {
+    for (int level = 1; level < m->levels; level++) {
+        queue_append(m->queues[0], m->queues[level]);
+    }
+    for (handle_t p = m->queues[0]->head; p != NO_PROCESS; p = m->table->next[p]) {
+        m->table->level[p] = 0;
+        m->table->slice_used[p] = 0;
+    }
+    if (m->count) m->bitmap = 1;
+}
+
+/* Drops a process that used up its time slice one level, the lowest level keeps it */
+void mlfq_demote(mlfq_t *m, handle_t p) {
+    if (m->table->level[p] < m->levels - 1) m->table->level[p]++;
+    m->table->slice_used[p] = 0;
+}
+
+int mlfq_slice_expired(mlfq_t *m, handle_t p) {
+    return m->table->slice_used[p] >= m->slices[m->table->level[p]];
+}
+
+/* Sets the level and slice of a process that ran without being switched out for a number of
+   cycles, from the level and slice given, as if each cycle had been scheduled: a slice used up at
+   the start of a cycle demotes the process, or is renewed at the lowest level, and the process
+   then runs for a quantum. Event-driven time advance skips such cycles */
+void mlfq_skip_cycles(mlfq_t *m, handle_t p, int level, int64_t slice_used, int64_t cycles, int quantum) {
+    int lowest = m->levels - 1;
+
+    // cycles until each level above the lowest is used up
+    while (cycles > 0 && level < lowest) {
+        if (slice_used >= m->slices[level]) {
+            level++;
+            slice_used = 0;
+            continue;
+        }
+        int64_t runs = (m->slices[level] - slice_used + quantum - 1) / quantum;
+        if (runs > cycles) runs = cycles;
+        slice_used += runs * quantum;
+        cycles -= runs;
+    }
+
+    // then the lowest slice is renewed every period cycles
+    if (cycles > 0) {
+        int64_t slice = m->slices[lowest], period = (slice + quantum - 1) / quantum;
+        if (slice_used >= slice) slice_used = 0;
+        int64_t runs = (slice - slice_used + quantum - 1) / quantum;
+        if (cycles <= runs) {
+            slice_used += cycles * quantum;
+        } else {
+            int64_t into_period = (cycles - runs) % period;
+            slice_used = (into_period ? into_period : period) * quantum;
+        }
+    }
+
+    m->table->level[p] = level;
+    m->table->slice_used[p] = slice_used;
+}
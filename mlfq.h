@@ -0,0 +1,35 @@
+#ifndef _MLFQ_H_
+#define _MLFQ_H_
+
+#include<stdlib.h>
+#include<stdint.h>
+#include<assert.h>
+#include"queues.h"
+
+#define MLFQ_MAX_LEVELS 64  // one bit per level in the priority bitmap
+#define MLFQ_LEVELS 3
+#define MLFQ_BOOST_CYCLES 64
+
+// multi-level feedback queue, one FIFO per priority level with level 0 the highest,
+// and a bitmap of the levels that have processes so the next one is found in O(1)
+typedef struct {
+    int levels;
+    int64_t slices[MLFQ_MAX_LEVELS];    // time a process may run at each level before demotion
+    queue_t *queues[MLFQ_MAX_LEVELS];
+    uint64_t bitmap;                // bit i set while level i is not empty
+    int count;
+    process_table_t *table;
+} mlfq_t;
+
+mlfq_t* make_mlfq(int levels, int64_t *slices, process_table_t *table);
+void free_mlfq(mlfq_t *m);
+void mlfq_enqueue_process(mlfq_t *m, handle_t p);
+handle_t mlfq_dequeue_process(mlfq_t *m);
+handle_t mlfq_peek_process(mlfq_t *m);
+int mlfq_top_level(mlfq_t *m);
+void mlfq_boost(mlfq_t *m);
+void mlfq_demote(mlfq_t *m, handle_t p);
+void mlfq_skip_cycles(mlfq_t *m, handle_t p, int level, int64_t slice_used, int64_t cycles, int quantum);
+int mlfq_slice_expired(mlfq_t *m, handle_t p);
+
+#endif
@@ -0,0 +1,341 @@
+#include"output.h"
+
+static const char *event_names[] = {
+    [EVENT_READY] = ",READY,process_name=",
+    [EVENT_RUNNING] = ",RUNNING,process_name=",
+    [EVENT_FINISHED] = ",FINISHED,process_name=",
+    [EVENT_EVICTED] = ",EVICTED,process_name=",
+    [EVENT_FAULTED] = ",FAULTED,process_name=",
+};
+
+static const char *event_fields[] = {
+    [EVENT_READY] = ",assigned_at=",
+    [EVENT_RUNNING] = ",remaining_time=",
+    [EVENT_FINISHED] = ",proc_remaining=",
+    [EVENT_EVICTED] = ",pages=",
+    [EVENT_FAULTED] = ",pages=",
+};
+
+static void write_record(writer_t *w, int type, int cpu, uint32_t process_id, int64_t time, int64_t field);
+
+writer_t* make_writer(int fd, int format, int cpus) {
+    writer_t *w = malloc(sizeof(writer_t));
+    assert(w!=NULL);
+
+    w->fd = fd;
+    w->format = format;
+    w->cpus = cpus < 1 ? 1 : cpus;
+    w->buffer = NULL;
+    w->used = 0;
+    w->callback = NULL;
+    w->context = NULL;
+    w->error = 0;
+    if (format == DISCARD) return w;
+
+    w->buffer = malloc(WRITER_BUFFER_BYTES);
+    assert(w->buffer!=NULL);
+
+    if (format == BINARY) write_record(w, EVENT_HEADER, w->cpus - 1, EVENT_LOG_MAGIC, 0, EVENT_LOG_VERSION);
+
+    return w;
+}
+
+/* Hands every event to callback as it happens, with the name of the process it is about. Nothing
+   is buffered, and the statistics come as the records of a binary log */
+writer_t* make_callback_writer(event_callback_t callback, void *context, int cpus) {
+    writer_t *w = make_writer(-1, DISCARD, cpus);
+    w->format = CALLBACK;
+    w->callback = callback;
+    w->context = context;
+
+    return w;
+}
+
+/* Writes length bytes to the file, unless a write has already failed */
+static void write_all(writer_t *w, const char *data, size_t length) {
+    size_t written = 0;
+
+    while (written < length && !w->error) {
+        ssize_t n = write(w->fd, data + written, length - written);
+        if (n == -1 && errno == EINTR) continue;
+        if (n == -1) w->error = errno;
+        else written += n;
+    }
+}
+
+/* Writes out the buffer. Returns -1 once a write has failed, after which events are dropped
+   and w->error holds its errno */
+int flush_writer(writer_t *w) {
+    write_all(w, w->buffer, w->used);
+    w->used = 0;
+
+    return w->error ? -1 : 0;
+}
+
+/* Flushes what is left, returns -1 if any write failed */
+int free_writer(writer_t *w) {
+    int status = flush_writer(w);
+    free(w->buffer);
+    free(w);
+    return status;
+}
+
+/* Makes room for at least bytes in the buffer, anything longer goes through write_bytes */
+static char* reserve(writer_t *w, size_t bytes) {
+    assert(bytes <= WRITER_BUFFER_BYTES);
+    if (WRITER_BUFFER_BYTES - w->used < bytes) flush_writer(w);
+    return w->buffer + w->used;
+}
+
+/* Appends bytes of any length, those that do not fit in the buffer are written straight out
+   after it */
+static void write_bytes(writer_t *w, const char *s, size_t length) {
+    if (WRITER_BUFFER_BYTES - w->used < length) flush_writer(w);
+    if (length > WRITER_BUFFER_BYTES) {
+        write_all(w, s, length);
+        return;
+    }
+    memcpy(w->buffer + w->used, s, length);
+    w->used += length;
+}
+
+static char* append_bytes(char *out, const char *s, size_t length) {
+    memcpy(out, s, length);
+    return out + length;
+}
+
+/* Formats a decimal integer without going through printf */
+static char* append_int(char *out, int64_t value) {
+    char digits[20];
+    int n = 0;
+    uint64_t v = value < 0 ? -(uint64_t)value : (uint64_t)value;
+
+    if (value < 0) *out++ = '-';
+    do {
+        digits[n++] = '0' + v % 10;
+        v /= 10;
+    } while (v);
+    while (n) *out++ = digits[--n];
+
+    return out;
+}
+
+/* Appends a record to a binary log, or hands it to the callback */
+static void write_record(writer_t *w, int type, int cpu, uint32_t process_id, int64_t time, int64_t field) {
+    if (w->format == CALLBACK) {
+        event_record_t r = { .type = type, .cpu = cpu, .process_id = process_id, .time = time, .field = field };
+        w->callback(w->context, &r, NULL, 0);
+        return;
+    }
+
+    event_record_t *r = (event_record_t *)reserve(w, sizeof(event_record_t));
+
+    memset(r, 0, sizeof(event_record_t));
+    r->type = type;
+    r->cpu = cpu;
+    r->process_id = process_id;
+    r->time = time;
+    r->field = field;
+    w->used += sizeof(event_record_t);
+}
+
+/* Introduces a process' name to a binary log, text output names processes in every event */
+void write_process_name(writer_t *w, int64_t time, uint32_t process_id, const char *name, int name_length) {
+    if (w->format != BINARY) return;
+
+    static const char zeros[sizeof(event_record_t)];
+    size_t padded = (name_length + sizeof(event_record_t) - 1) / sizeof(event_record_t) * sizeof(event_record_t);
+    write_record(w, EVENT_NAME, 0, process_id, time, name_length);
+
+    write_bytes(w, name, name_length);
+    write_bytes(w, zeros, padded - name_length);
+}
+
+/* The end of an event line, after the process name */
+static char* append_event_field(writer_t *w, char *out, const char *field_name, size_t field_length,
+    int64_t field, int cpu) {
+    out = append_bytes(out, field_name, field_length);
+    out = append_int(out, field);
+    if (w->cpus > 1) {
+        out = append_bytes(out, ",cpu=", 5);
+        out = append_int(out, cpu);
+    }
+    *out++ = '\n';
+    return out;
+}
+
+/* READY, RUNNING and FINISHED events */
+void write_process_event(writer_t *w, int type, int64_t time, uint32_t process_id,
+    const char *name, int name_length, int64_t field, int cpu) {
+    if (w->format == DISCARD) return;
+    if (w->format == CALLBACK) {
+        event_record_t r = { .type = type, .cpu = cpu, .process_id = process_id, .time = time, .field = field };
+        w->callback(w->context, &r, name, name_length);
+        return;
+    }
+    if (w->format == BINARY) {
+        write_record(w, type, cpu, process_id, time, field);
+        return;
+    }
+
+    const char *event = event_names[type], *field_name = event_fields[type];
+    size_t event_length = strlen(event), field_length = strlen(field_name);
+    size_t line_length = 3 * 21 + event_length + name_length + field_length + 5 + 1;
+
+    // a name longer than the buffer is written out between the two halves of its line
+    if (line_length > WRITER_BUFFER_BYTES) {
+        char *start = reserve(w, 21 + event_length);
+        w->used += append_bytes(append_int(start, time), event, event_length) - start;
+        write_bytes(w, name, name_length);
+        start = reserve(w, 2 * 21 + field_length + 5 + 1);
+        w->used += append_event_field(w, start, field_name, field_length, field, cpu) - start;
+        return;
+    }
+
+    char *start = reserve(w, line_length);
+    char *out = start;
+
+    out = append_int(out, time);
+    out = append_bytes(out, event, event_length);
+    out = append_bytes(out, name, name_length);
+    out = append_event_field(w, out, field_name, field_length, field, cpu);
+
+    w->used += out - start;
+}
+
+/* Summary lines printed once the simulation has finished */
+void write_statistics(writer_t *w, double turnaround, double max_overhead, double average_overhead,
+    int64_t makespan) {
+    if (w->format == DISCARD) return;
+    if (w->format != TEXT) {
+        int64_t bits;
+        memcpy(&bits, &turnaround, sizeof(bits));
+        write_record(w, EVENT_TURNAROUND, 0, 0, makespan, bits);
+        memcpy(&bits, &max_overhead, sizeof(bits));
+        write_record(w, EVENT_MAX_OVERHEAD, 0, 0, makespan, bits);
+        memcpy(&bits, &average_overhead, sizeof(bits));
+        write_record(w, EVENT_AVERAGE_OVERHEAD, 0, 0, makespan, bits);
+        write_record(w, EVENT_MAKESPAN, 0, 0, makespan, makespan);
+        return;
+    }
+
+    char *out = reserve(w, 3 * 512);
+    int n = 0;
+    n += sprintf(out + n, "Turnaround time %.0f\n", turnaround);
+    n += sprintf(out + n, "Time overhead %.2f %.2f\n", max_overhead, average_overhead);
+    n += sprintf(out + n, "Makespan %lld\n", (long long)makespan);
+    w->used += n;
+}
+
+/* Summary line of one CPU, its utilisation is its busy time over the whole run's makespan */
+void write_cpu_statistics(writer_t *w, int cpu, int64_t busy_time, int64_t cpu_makespan, int64_t makespan) {
+    if (w->format == DISCARD) return;
+    if (w->format != TEXT) {
+        write_record(w, EVENT_CPU, cpu, 0, cpu_makespan, busy_time);
+        return;
+    }
+
+    char *out = reserve(w, 512);
+    w->used += sprintf(out, "CPU %d utilisation %.2f makespan %lld\n", cpu,
+        makespan > 0 ? 100.0 * busy_time / makespan : 0, (long long)cpu_makespan);
+}
+
+/* Measured latency of the real execution backend, in microseconds */
+void write_latency_statistics(writer_t *w, int kind, uint64_t count, uint64_t total_ns, uint64_t max_ns) {
+    if (w->format == DISCARD) return;
+    if (w->format != TEXT) {
+        write_record(w, EVENT_LATENCY, kind, count, total_ns, max_ns);
+        return;
+    }
+
+    char *out = reserve(w, 512);
+    w->used += sprintf(out, "%s latency mean %.1fus max %.1fus count %llu\n",
+        kind == LATENCY_DISPATCH ? "Dispatch" : "Context switch", count ? total_ns / 1000.0 / count : 0, max_ns / 1000.0,
+        (unsigned long long)count);
+}
+
+/* Memory was compacted to admit a process */
+void write_compaction(writer_t *w, int64_t time, int64_t moved_mb) {
+    if (w->format == DISCARD) return;
+    if (w->format != TEXT) {
+        write_record(w, EVENT_COMPACTION, 0, 0, time, moved_mb);
+        return;
+    }
+
+    char *out = reserve(w, 512);
+    w->used += sprintf(out, "%lld,COMPACTED,moved_mb=%lld\n", (long long)time, (long long)moved_mb);
+}
+
+/* Summary line of the compactions, the stall is the simulated time charged for moving memory */
+/* A *_STATS record, the count split between process_id and cpu */
+static void write_count_record(writer_t *w, int type, int64_t count, int64_t time, int64_t field) {
+    write_record(w, type, (count >> 32) & 0xffff, (uint32_t)count, time, field);
+}
+
+void write_compaction_statistics(writer_t *w, int64_t compactions, int64_t moved_mb, int64_t stall) {
+    if (w->format == DISCARD) return;
+    if (w->format != TEXT) {
+        write_count_record(w, EVENT_COMPACTION_STATS, compactions, stall, moved_mb);
+        return;
+    }
+
+    char *out = reserve(w, 512);
+    w->used += sprintf(out, "Compactions %" PRId64 " moved %" PRId64 "MB stalled %" PRId64 "\n", compactions,
+        moved_mb, stall);
+}
+
+/* Summary line of backfilling, a hit is a reserved process admitted by the time it was promised */
+void write_reservation_statistics(writer_t *w, int64_t reservations, int64_t hits, int64_t misses) {
+    if (w->format == DISCARD) return;
+    if (w->format != TEXT) {
+        write_count_record(w, EVENT_RESERVATION_STATS, reservations, hits, misses);
+        return;
+    }
+
+    char *out = reserve(w, 512);
+    w->used += sprintf(out, "Reservations %" PRId64 " hits %" PRId64 " misses %" PRId64 "\n", reservations,
+        hits, misses);
+}
+
+/* Summary line of paged and virtual memory, in pages of 4 KiB */
+void write_paging_statistics(writer_t *w, int64_t evictions, int64_t page_faults, int64_t pages_evicted) {
+    if (w->format == DISCARD) return;
+    if (w->format != TEXT) {
+        write_count_record(w, EVENT_PAGING_STATS, evictions, page_faults, pages_evicted);
+        return;
+    }
+
+    char *out = reserve(w, 512);
+    w->used += sprintf(out, "Page faults %" PRId64 " evictions %" PRId64 " evicted %" PRId64 " pages\n",
+        page_faults, evictions, pages_evicted);
+}
+
+/* Percentile line of one histogram, values scaled by more than 1 keep two decimals */
+void write_percentiles(writer_t *w, int kind, int64_t scale, const int64_t *values) {
+    static const char *labels[HISTOGRAM_COUNT] = {
+        [HISTOGRAM_TURNAROUND] = "Turnaround time",
+        [HISTOGRAM_WAIT] = "Wait time",
+        [HISTOGRAM_OVERHEAD] = "Time overhead",
+        [HISTOGRAM_ADMISSION] = "Admission delay",
+    };
+
+    if (w->format == DISCARD) return;
+    if (w->format != TEXT) {
+        for (int i = 0; i < PERCENTILE_COUNT; i++) write_record(w, EVENT_PERCENTILE, kind, i, scale, values[i]);
+        return;
+    }
+
+    char *out = reserve(w, 1024);
+    int n = sprintf(out, "%s percentiles", labels[kind]);
+    for (int i = 0; i < PERCENTILE_COUNT; i++) {
+        int tenths = percentiles[i];
+        if (tenths == 1000) n += sprintf(out + n, " max");
+        else if (tenths % 10) n += sprintf(out + n, " p%d.%d", tenths / 10, tenths % 10);
+        else n += sprintf(out + n, " p%d", tenths / 10);
+
+        if (scale > 1) n += sprintf(out + n, " %.2f", (double)values[i] / scale);
+        else n += sprintf(out + n, " %lld", (long long)values[i]);
+    }
+    out[n++] = '\n';
+    w->used += n;
+}
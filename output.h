@@ -0,0 +1,102 @@
+#ifndef _OUTPUT_H_
+#define _OUTPUT_H_
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<stdint.h>
+#include<inttypes.h>
+#include<assert.h>
+#include<unistd.h>
+#include<errno.h>
+#include"histogram.h"
+
+#define TEXT 0
+#define BINARY 1
+#define DISCARD 2   // only the statistics are kept, by the caller
+#define CALLBACK 3  // every event is handed to a function as a record
+
+#define WRITER_BUFFER_BYTES (1 << 20)
+
+// Event types, also the type of binary event log records
+#define EVENT_HEADER 0
+#define EVENT_NAME 1
+#define EVENT_READY 2
+#define EVENT_RUNNING 3
+#define EVENT_FINISHED 4
+#define EVENT_TURNAROUND 5
+#define EVENT_MAX_OVERHEAD 6
+#define EVENT_AVERAGE_OVERHEAD 7
+#define EVENT_MAKESPAN 8
+#define EVENT_CPU 9
+#define EVENT_LATENCY 10
+#define EVENT_COMPACTION 11
+#define EVENT_COMPACTION_STATS 12
+#define EVENT_RESERVATION_STATS 13
+#define EVENT_PERCENTILE 14
+#define EVENT_EVICTED 15
+#define EVENT_FAULTED 16
+#define EVENT_PAGING_STATS 17
+
+// measured latencies of the real execution backend
+#define LATENCY_DISPATCH 0
+#define LATENCY_SWITCH 1
+
+#define EVENT_LOG_MAGIC 0x56454d50 // "PMEV"
+#define EVENT_LOG_VERSION 1
+
+// binary event log record. A NAME record is followed by the name, zero padded to whole records.
+// HEADER carries the magic in process_id, the version in field and the number of CPUs less one
+// in cpu, and the overhead records carry the bits of a double in field. CPU records carry a
+// CPU's makespan in time and its busy time in field. LATENCY records carry the kind in cpu, the
+// count in process_id, the total in time and the maximum in field, all in nanoseconds. COMPACTION
+// records carry the MB moved in field, COMPACTION_STATS the number of compactions in process_id,
+// the time stalled in time and the MB moved in field. RESERVATION_STATS records carry the number
+// of reservations in process_id, the hits in time and the misses in field. The counts of the
+// *_STATS records take the low 32 bits of a 48-bit count, and cpu the high 16. PERCENTILE records
+// carry the histogram in cpu, the index of the percentile in process_id, the histogram's scale in
+// time and the value in field, a line is printed once the last percentile of a histogram is read.
+// EVICTED and FAULTED records carry the pages in field, PAGING_STATS records the number of
+// evictions in process_id, the page faults in time and the pages evicted in field
+typedef struct {
+    uint8_t type;
+    uint8_t reserved;
+    uint16_t cpu;
+    uint32_t process_id;
+    int64_t time;
+    int64_t field;
+} event_record_t;
+
+// called with each event of a CALLBACK writer, the name is NULL unless the event is about a process
+typedef void (*event_callback_t)(void *context, const event_record_t *record, const char *name, int name_length);
+
+// buffers events and writes them to a file descriptor in large blocks
+typedef struct {
+    int fd;
+    int format;
+    int cpus;           // events are tagged with their CPU when there is more than one
+    char *buffer;
+    size_t used;
+    event_callback_t callback;
+    void *context;
+    int error;          // errno of the first write that failed
+} writer_t;
+
+writer_t* make_writer(int fd, int format, int cpus);
+writer_t* make_callback_writer(event_callback_t callback, void *context, int cpus);
+int flush_writer(writer_t *w);
+int free_writer(writer_t *w);
+void write_process_name(writer_t *w, int64_t time, uint32_t process_id, const char *name, int name_length);
+void write_process_event(writer_t *w, int type, int64_t time, uint32_t process_id,
+     const char *name, int name_length, int64_t field, int cpu);
+void write_statistics(writer_t *w, double turnaround, double max_overhead, double average_overhead,
+     int64_t makespan);
+void write_cpu_statistics(writer_t *w, int cpu, int64_t busy_time, int64_t cpu_makespan, int64_t makespan);
+void write_latency_statistics(writer_t *w, int kind, uint64_t count, uint64_t total_ns, uint64_t max_ns);
+void write_compaction(writer_t *w, int64_t time, int64_t moved_mb);
+void write_compaction_statistics(writer_t *w, int64_t compactions, int64_t moved_mb, int64_t stall);
+void write_reservation_statistics(writer_t *w, int64_t reservations, int64_t hits, int64_t misses);
+void write_percentiles(writer_t *w, int kind, int64_t scale, const int64_t *values);
+void write_paging_statistics(writer_t *w, int64_t evictions, int64_t page_faults, int64_t pages_evicted);
+
+#endif
@@ -0,0 +1,441 @@
+#include"paging.h"
+
+static int64_t bitmap_words(pager_t *pager) {
+    return (pager->frame_count + 63) / 64;
+}
+
+/* Sets or clears the bits of a run of frames, a word at a time */
+static void mark_frames(pager_t *pager, int64_t start, int64_t count, int free_frames) {
+    while (count > 0) {
+        int64_t word = start / 64;
+        int bit = start % 64;
+        int64_t bits = 64 - bit < count ? 64 - bit : count;
+        uint64_t mask = bits == 64 ? ~(uint64_t)0 : (((uint64_t)1 << bits) - 1) << bit;
+
+        if (free_frames) pager->free_bits[word] |= mask;
+        else pager->free_bits[word] &= ~mask;
+        start += bits;
+        count -= bits;
+    }
+}
+
+pager_t* make_pager(int64_t frame_count, int virtual_memory, stats_t *stats) {
+    pager_t *pager = calloc(1, sizeof(pager_t));
+    assert(pager!=NULL);
+    pager->virtual_memory = virtual_memory;
+    pager->frame_count = frame_count;
+    pager->stats = stats;
+
+    pager->free_bits = calloc(bitmap_words(pager), sizeof(uint64_t));
+    assert(pager->free_bits!=NULL);
+    mark_frames(pager, 0, frame_count, 1);
+    pager->free_frames = frame_count;
+
+    pager->lru_head = pager->lru_tail = NO_PROCESS;
+
+    return pager;
+}
+
+void free_pager(pager_t *pager) {
+    for (uint32_t i = 0; i < pager->capacity; i++) free(pager->processes[i].runs);
+    free(pager->processes);
+    free(pager->free_bits);
+    free(pager->events);
+    free(pager);
+}
+
+/* Makes room for the processes of a table that has grown */
+static void grow_processes(pager_t *pager, uint32_t capacity) {
+    if (capacity <= pager->capacity) return;
+
+    pager->processes = realloc(pager->processes, capacity * sizeof(paged_process_t));
+    assert(pager->processes!=NULL);
+    memset(pager->processes + pager->capacity, 0, (capacity - pager->capacity) * sizeof(paged_process_t));
+    pager->capacity = capacity;
+}
+
+/* Pages a process keeps however short memory is */
+static int64_t min_resident(pager_t *pager, paged_process_t *process) {
+    if (!pager->virtual_memory) return 0;
+    return process->pages < MIN_RESIDENT_PAGES ? process->pages : MIN_RESIDENT_PAGES;
+}
+
+static int64_t spare_pages(pager_t *pager, paged_process_t *process) {
+    return process->resident - min_resident(pager, process);
+}
+
+/* LRU list of the processes that are not running and have pages to give up, most recently run
+   at the head */
+
+static void lru_push(pager_t *pager, handle_t p) {
+    paged_process_t *process = &pager->processes[p];
+
+    process->listed = 1;
+    process->lru_prev = NO_PROCESS;
+    process->lru_next = pager->lru_head;
+    if (pager->lru_head != NO_PROCESS) pager->processes[pager->lru_head].lru_prev = p;
+    else pager->lru_tail = p;
+    pager->lru_head = p;
+    pager->evictable_frames += spare_pages(pager, process);
+}
+
+static void lru_remove(pager_t *pager, handle_t p) {
+    paged_process_t *process = &pager->processes[p];
+
+    if (process->lru_prev != NO_PROCESS) pager->processes[process->lru_prev].lru_next = process->lru_next;
+    else pager->lru_head = process->lru_next;
+    if (process->lru_next != NO_PROCESS) pager->processes[process->lru_next].lru_prev = process->lru_prev;
+    else pager->lru_tail = process->lru_prev;
+    process->listed = 0;
+    pager->evictable_frames -= spare_pages(pager, process);
+}
+
+static void add_event(pager_t *pager, handle_t p, int type, int64_t pages) {
+    if (pager->event_count == pager->event_capacity) {
+        pager->event_capacity = pager->event_capacity ? 2 * pager->event_capacity : 16;
+        pager->events = realloc(pager->events, pager->event_capacity * sizeof(page_event_t));
+        assert(pager->events!=NULL);
+    }
+    pager->events[pager->event_count++] = (page_event_t){ p, type, pages };
+}
+
+static void append_run(paged_process_t *process, int64_t start, int64_t count) {
+    if (process->run_count > 0) {
+        frame_run_t *last = &process->runs[process->run_count - 1];
+        if (last->start + last->count == start) {
+            last->count += count;
+            return;
+        }
+    }
+    if (process->run_count == process->run_capacity) {
+        process->run_capacity = process->run_capacity ? 2 * process->run_capacity : 4;
+        process->runs = realloc(process->runs, process->run_capacity * sizeof(frame_run_t));
+        assert(process->runs!=NULL);
+    }
+    process->runs[process->run_count++] = (frame_run_t){ start, count };
+}
+
+/* Gives a process count free frames, whole words of them where it can. There have to be enough */
+static void take_frames(pager_t *pager, paged_process_t *process, int64_t count) {
+    int64_t words = bitmap_words(pager), word = pager->next_word;
+
+    assert(count <= pager->free_frames);
+    pager->free_frames -= count;
+    process->resident += count;
+
+    while (count > 0) {
+        while (pager->free_bits[word] == 0) word = word + 1 < words ? word + 1 : 0;
+
+        // the run of free frames from the lowest free one in the word
+        uint64_t bits = pager->free_bits[word];
+        int bit = __builtin_ctzll(bits);
+        uint64_t taken = ~(bits >> bit);
+        int64_t run = taken ? __builtin_ctzll(taken) : 64 - bit;
+        if (run > count) run = count;
+
+        mark_frames(pager, word * 64 + bit, run, 0);
+        append_run(process, word * 64 + bit, run);
+        count -= run;
+    }
+    pager->next_word = word;
+}
+
+/* Frees the last count frames a process was given */
+static void drop_frames(pager_t *pager, paged_process_t *process, int64_t count) {
+    pager->free_frames += count;
+    process->resident -= count;
+
+    while (count > 0) {
+        frame_run_t *last = &process->runs[process->run_count - 1];
+        int64_t run = last->count < count ? last->count : count;
+
+        mark_frames(pager, last->start + last->count - run, run, 1);
+        last->count -= run;
+        if (last->count == 0) process->run_count--;
+        count -= run;
+    }
+}
+
+/* Evicts pages of the least recently run processes until at least count frames have been freed.
+   Enough have to be evictable */
+static void evict_frames(pager_t *pager, int64_t count) {
+    while (count > 0) {
+        handle_t victim = pager->lru_tail;
+        assert(victim != NO_PROCESS);
+        paged_process_t *process = &pager->processes[victim];
+
+        // paged memory swaps the whole process out
+        int64_t pages = spare_pages(pager, process);
+        if (pager->virtual_memory && pages > count) pages = count;
+
+        pager->evictable_frames -= pages;
+        drop_frames(pager, process, pages);
+        if (spare_pages(pager, process) == 0) lru_remove(pager, victim);
+
+        add_event(pager, victim, PAGE_EVICTED, pages);
+        pager->evictions++;
+        pager->pages_evicted += pages;
+        count -= pages;
+    }
+}
+
+/* Frames for the pages a process needs resident to be admitted, evicting others' pages if need
+   be. Returns the first frame it was given, or -1 if not enough can be freed */
+int64_t pager_allocate(pager_t *pager, process_table_t *table, handle_t p, int64_t pages) {
+    if (pages < 1) pages = 1;
+    // virtual memory only needs the minimum resident, the rest is faulted in as the process runs
+    if (!pager->virtual_memory && pages > pager->frame_count) return -1;
+    grow_processes(pager, table->capacity);
+
+    paged_process_t *process = &pager->processes[p];
+    process->pages = pages;
+    int64_t needed = min_resident(pager, process);
+    if (!pager->virtual_memory) needed = pages;
+    if (needed > pager->free_frames + pager->evictable_frames) {
+        process->pages = 0;
+        return -1;
+    }
+
+    if (needed > pager->free_frames) evict_frames(pager, needed - pager->free_frames);
+    take_frames(pager, process, needed);
+    process->running = 0;
+    if (spare_pages(pager, process) > 0) lru_push(pager, p);
+
+    return process->runs[0].start;
+}
+
+void pager_release(pager_t *pager, handle_t p) {
+    paged_process_t *process = &pager->processes[p];
+
+    if (process->listed) lru_remove(pager, p);
+    drop_frames(pager, process, process->resident);
+    process->pages = 0;
+    process->running = 0;
+}
+
+/* A process is put on a CPU, and the one switched out for it can have its pages evicted again.
+   The pages of p that are out are faulted back in, as many as can be */
+void pager_run(pager_t *pager, process_table_t *table, handle_t p, handle_t switched_out) {
+    grow_processes(pager, table->capacity);
+
+    if (switched_out != NO_PROCESS && pager->processes[switched_out].pages > 0) {
+        paged_process_t *previous = &pager->processes[switched_out];
+        previous->running = 0;
+        if (spare_pages(pager, previous) > 0) lru_push(pager, switched_out);
+    }
+
+    paged_process_t *process = &pager->processes[p];
+    if (process->pages == 0) return;
+    if (process->listed) lru_remove(pager, p);
+    process->running = 1;
+
+    int64_t missing = process->pages - process->resident;
+    int64_t available = pager->free_frames + pager->evictable_frames;
+    int64_t faulted = missing < available ? missing : available;
+    if (faulted <= 0) return;
+
+    if (faulted > pager->free_frames) evict_frames(pager, faulted - pager->free_frames);
+    take_frames(pager, process, faulted);
+    add_event(pager, p, PAGE_FAULTED, faulted);
+    pager->page_faults += faulted;
+}
+
+/* Whether every page of p can be made resident once switched_out gives up its CPU. The frames of
+   processes running on other CPUs cannot be evicted meanwhile */
+int pager_can_run(pager_t *pager, process_table_t *table, handle_t p, handle_t switched_out) {
+    grow_processes(pager, table->capacity);
+
+    paged_process_t *process = &pager->processes[p];
+    int64_t available = pager->free_frames + pager->evictable_frames;
+    if (process->listed) available -= spare_pages(pager, process);
+    if (switched_out != NO_PROCESS && pager->processes[switched_out].running) {
+        available += spare_pages(pager, &pager->processes[switched_out]);
+    }
+
+    return process->pages - process->resident <= available;
+}
+
+/* Evictions and faults since it was last called, valid until the pager is next used */
+uint32_t pager_events(pager_t *pager, const page_event_t **events) {
+    uint32_t count = pager->event_count;
+    *events = pager->events;
+    pager->event_count = 0;
+    return count;
+}
+
+/* Frames of the largest process that can be admitted now, virtual memory admits any process once
+   its minimum fits, however much larger than memory it is */
+int64_t pager_admittable(pager_t *pager) {
+    int64_t available = pager->free_frames + pager->evictable_frames;
+    if (pager->virtual_memory && available >= MIN_RESIDENT_PAGES) return INT64_MAX >> PAGE_SHIFT;
+    return available;
+}
+
+/* Saves the bitmap, the frames of each process and the LRU list into buffer, returns the bytes
+   they take. A NULL buffer only sizes them */
+size_t checkpoint_pager(pager_t *pager, void *buffer) {
+    size_t length = sizeof(checkpoint_pager_t) + bitmap_words(pager) * sizeof(uint64_t);
+    uint32_t count = 0;
+
+    char *out = buffer ? (char *)buffer + length : NULL;
+    for (uint32_t i = 0; i < pager->capacity; i++) {
+        paged_process_t *process = &pager->processes[i];
+        if (process->pages == 0) continue;
+
+        size_t runs_length = process->run_count * sizeof(frame_run_t);
+        if (out) {
+            checkpoint_paged_process_t *saved = (checkpoint_paged_process_t *)out;
+            memset(saved, 0, sizeof(checkpoint_paged_process_t));
+            saved->handle = i;
+            saved->run_count = process->run_count;
+            saved->pages = process->pages;
+            saved->resident = process->resident;
+            saved->lru_prev = process->lru_prev;
+            saved->lru_next = process->lru_next;
+            saved->running = process->running;
+            saved->listed = process->listed;
+            memcpy(saved + 1, process->runs, runs_length);
+            out += sizeof(checkpoint_paged_process_t) + runs_length;
+        }
+        length += sizeof(checkpoint_paged_process_t) + runs_length;
+        count++;
+    }
+    if (!buffer) return length;
+
+    checkpoint_pager_t *header = buffer;
+    memset(header, 0, sizeof(checkpoint_pager_t));
+    header->virtual_memory = pager->virtual_memory;
+    header->process_count = count;
+    header->frame_count = pager->frame_count;
+    header->free_frames = pager->free_frames;
+    header->next_word = pager->next_word;
+    header->evictable_frames = pager->evictable_frames;
+    header->lru_head = pager->lru_head;
+    header->lru_tail = pager->lru_tail;
+    header->page_faults = pager->page_faults;
+    header->evictions = pager->evictions;
+    header->pages_evicted = pager->pages_evicted;
+    memcpy(header + 1, pager->free_bits, bitmap_words(pager) * sizeof(uint64_t));
+
+    return length;
+}
+
+/* Whether saved processes fill the rest of a saved pager, with handles in the table and frames
+   in memory */
+static int valid_paged_processes(pager_t *pager, process_table_t *table, const checkpoint_pager_t *header,
+    const char *in, size_t length) {
+    for (uint32_t i = 0; i < header->process_count; i++) {
+        const checkpoint_paged_process_t *saved = (const checkpoint_paged_process_t *)in;
+        if (length < sizeof(checkpoint_paged_process_t)) return 0;
+        length -= sizeof(checkpoint_paged_process_t);
+        if (saved->handle >= table->capacity || saved->run_count > length / sizeof(frame_run_t)
+            || (saved->lru_prev != NO_PROCESS && saved->lru_prev >= table->capacity)
+            || (saved->lru_next != NO_PROCESS && saved->lru_next >= table->capacity)
+            || saved->resident < 0 || saved->resident > saved->pages) {
+            return 0;
+        }
+
+        const frame_run_t *runs = (const frame_run_t *)(saved + 1);
+        int64_t frames = 0;
+        for (uint32_t r = 0; r < saved->run_count; r++) {
+            if (runs[r].start < 0 || runs[r].count < 1 || runs[r].count > pager->frame_count - runs[r].start) return 0;
+            frames += runs[r].count;
+        }
+        if (frames != saved->resident) return 0;
+        length -= saved->run_count * sizeof(frame_run_t);
+        in += sizeof(checkpoint_paged_process_t) + saved->run_count * sizeof(frame_run_t);
+    }
+    return length == 0;
+}
+
+/* Whether the saved processes' runs and the saved free bits split the frames between them, each
+   frame held by one process or free */
+static int frames_partitioned(pager_t *pager, const checkpoint_pager_t *header) {
+    const uint64_t *free_bits = (const uint64_t *)(header + 1);
+    int64_t words = bitmap_words(pager);
+    uint64_t *held = calloc(words, sizeof(uint64_t));
+    assert(held!=NULL);
+
+    int valid = 1;
+    const char *in = (const char *)(header + 1) + words * sizeof(uint64_t);
+    for (uint32_t i = 0; i < header->process_count && valid; i++) {
+        const checkpoint_paged_process_t *saved = (const checkpoint_paged_process_t *)in;
+        const frame_run_t *runs = (const frame_run_t *)(saved + 1);
+        for (uint32_t r = 0; r < saved->run_count && valid; r++) {
+            int64_t start = runs[r].start, count = runs[r].count;
+            while (count > 0 && valid) {
+                int64_t word = start / 64;
+                int bit = start % 64;
+                int64_t bits = 64 - bit < count ? 64 - bit : count;
+                uint64_t mask = bits == 64 ? ~(uint64_t)0 : (((uint64_t)1 << bits) - 1) << bit;
+                valid = !(held[word] & mask) && !(free_bits[word] & mask);
+                held[word] |= mask;
+                start += bits;
+                count -= bits;
+            }
+        }
+        in += sizeof(checkpoint_paged_process_t) + saved->run_count * sizeof(frame_run_t);
+    }
+    for (int64_t word = 0; word < words && valid; word++) {
+        int64_t bits = pager->frame_count - word * 64 < 64 ? pager->frame_count - word * 64 : 64;
+        uint64_t mask = bits == 64 ? ~(uint64_t)0 : ((uint64_t)1 << bits) - 1;
+        valid = (held[word] | free_bits[word]) == mask && !(free_bits[word] & ~mask);
+    }
+
+    free(held);
+    return valid;
+}
+
+/* Replaces the frames with saved ones, returns -1 unless the memory size matches and every frame
+   is either free or held by one process */
+int restore_pager(pager_t *pager, process_table_t *table, const void *data, size_t length) {
+    const checkpoint_pager_t *header = data;
+    size_t bitmap_length = bitmap_words(pager) * sizeof(uint64_t);
+    if (length < sizeof(checkpoint_pager_t) + bitmap_length || header->frame_count != pager->frame_count
+        || header->virtual_memory != pager->virtual_memory
+        || (header->lru_head != NO_PROCESS && header->lru_head >= table->capacity)
+        || (header->lru_tail != NO_PROCESS && header->lru_tail >= table->capacity)
+        || header->next_word < 0 || header->next_word >= bitmap_words(pager)
+        || !valid_paged_processes(pager, table, header, (const char *)(header + 1) + bitmap_length,
+            length - sizeof(checkpoint_pager_t) - bitmap_length)
+        || !frames_partitioned(pager, header)) {
+        return -1;
+    }
+
+    // the free count is taken from the bits, which take_frames relies on agreeing with it
+    const uint64_t *bits = (const uint64_t *)(header + 1);
+    pager->free_frames = 0;
+    for (int64_t i = 0; i < bitmap_words(pager); i++) pager->free_frames += __builtin_popcountll(bits[i]);
+    pager->next_word = header->next_word;
+    pager->evictable_frames = header->evictable_frames;
+    pager->lru_head = header->lru_head;
+    pager->lru_tail = header->lru_tail;
+    pager->page_faults = header->page_faults;
+    pager->evictions = header->evictions;
+    pager->pages_evicted = header->pages_evicted;
+    memcpy(pager->free_bits, header + 1, bitmap_words(pager) * sizeof(uint64_t));
+
+    grow_processes(pager, table->capacity);
+    for (uint32_t i = 0; i < pager->capacity; i++) pager->processes[i].pages = 0;
+
+    const char *in = (const char *)(header + 1) + bitmap_words(pager) * sizeof(uint64_t);
+    for (uint32_t i = 0; i < header->process_count; i++) {
+        const checkpoint_paged_process_t *saved = (const checkpoint_paged_process_t *)in;
+        grow_processes(pager, saved->handle + 1);
+
+        paged_process_t *process = &pager->processes[saved->handle];
+        process->pages = saved->pages;
+        process->resident = saved->resident;
+        process->lru_prev = saved->lru_prev;
+        process->lru_next = saved->lru_next;
+        process->running = saved->running;
+        process->listed = saved->listed;
+        process->run_count = 0;
+        for (uint32_t r = 0; r < saved->run_count; r++) {
+            const frame_run_t *run = (const frame_run_t *)(saved + 1) + r;
+            append_run(process, run->start, run->count);
+        }
+        in += sizeof(checkpoint_paged_process_t) + saved->run_count * sizeof(frame_run_t);
+    }
+    return 0;
+}
@@ -0,0 +1,118 @@
+#ifndef _PAGING_H_
+#define _PAGING_H_
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<stdint.h>
+#include<string.h>
+#include<assert.h>
+#include"queues.h"
+#include"stats.h"
+
+// memory is split into frames of 4 KiB, a process' pages go in any free frames
+#define PAGE_SHIFT 12
+
+// the frame bitmap of a TB takes 32MB
+#define MAX_PAGED_MEMORY_MB ((int64_t)1 << 20)
+
+// pages a process keeps resident under virtual memory, or all of them if it has fewer
+#define MIN_RESIDENT_PAGES 256
+
+#define PAGE_EVICTED 0
+#define PAGE_FAULTED 1
+
+// a run of consecutive frames
+typedef struct {
+    int64_t start;
+    int64_t count;
+} frame_run_t;
+
+// what happened to a process' pages, kept until the caller has reported it
+typedef struct {
+    handle_t p;
+    int type;
+    int64_t pages;
+} page_event_t;
+
+// the frames of one process, by its handle
+typedef struct {
+    int64_t pages;              // it needs, 0 while the handle holds no process
+    int64_t resident;           // in frames now
+    frame_run_t *runs;
+    uint32_t run_count;
+    uint32_t run_capacity;
+    handle_t lru_prev;          // towards the most recently run
+    handle_t lru_next;
+    uint8_t running;            // its pages cannot be evicted meanwhile
+    uint8_t listed;             // in the LRU list, while it is not running and has pages to give up
+} paged_process_t;
+
+// Frames are tracked in a bitmap, and processes with pages that can be evicted in an intrusive
+// LRU list ordered by when they last ran, so the victim is always its tail. Paged memory swaps a
+// victim's pages out all at once and has a process' pages all resident while it runs. Virtual
+// memory only needs MIN_RESIDENT_PAGES of a process resident, and evicts no more pages than it
+// needs, never taking a process below that minimum
+typedef struct {
+    int virtual_memory;
+    int64_t frame_count;
+    uint64_t *free_bits;        // bit i set while frame i is free
+    int64_t free_frames;
+    int64_t next_word;          // the search for free frames resumes here
+    int64_t evictable_frames;   // held by the processes in the LRU list beyond their minimum
+
+    paged_process_t *processes;
+    uint32_t capacity;
+    handle_t lru_head;
+    handle_t lru_tail;
+
+    page_event_t *events;
+    uint32_t event_count;
+    uint32_t event_capacity;
+
+    int64_t page_faults;
+    int64_t evictions;
+    int64_t pages_evicted;
+    stats_t *stats;
+} pager_t;
+
+// the pager as saved in a checkpoint, followed by its bitmap words and a checkpoint_paged_process_t
+// with the frame runs of each process holding frames
+typedef struct {
+    int32_t virtual_memory;
+    uint32_t process_count;
+    int64_t frame_count;
+    int64_t free_frames;
+    int64_t next_word;
+    int64_t evictable_frames;
+    uint32_t lru_head;
+    uint32_t lru_tail;
+    int64_t page_faults;
+    int64_t evictions;
+    int64_t pages_evicted;
+} checkpoint_pager_t;
+
+typedef struct {
+    uint32_t handle;
+    uint32_t run_count;
+    int64_t pages;
+    int64_t resident;
+    uint32_t lru_prev;
+    uint32_t lru_next;
+    uint8_t running;
+    uint8_t listed;
+    uint16_t reserved;
+    uint32_t reserved2;
+} checkpoint_paged_process_t;
+
+pager_t* make_pager(int64_t frame_count, int virtual_memory, stats_t *stats);
+void free_pager(pager_t *pager);
+int64_t pager_allocate(pager_t *pager, process_table_t *table, handle_t p, int64_t pages);
+void pager_release(pager_t *pager, handle_t p);
+void pager_run(pager_t *pager, process_table_t *table, handle_t p, handle_t switched_out);
+int pager_can_run(pager_t *pager, process_table_t *table, handle_t p, handle_t switched_out);
+uint32_t pager_events(pager_t *pager, const page_event_t **events);
+int64_t pager_admittable(pager_t *pager);
+size_t checkpoint_pager(pager_t *pager, void *buffer);
+int restore_pager(pager_t *pager, process_table_t *table, const void *data, size_t length);
+
+#endif
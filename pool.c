@@ -0,0 +1,161 @@
+#include"pool.h"
+
+#define SLAB_TABLE_INITIAL_CAPACITY 16
+#define CHUNK_TABLE_INITIAL_CAPACITY 16
+
+pool_t* make_pool(size_t object_size) {
+    pool_t *pool = malloc(sizeof(pool_t));
+    assert(pool!=NULL);
+
+    // every object must be able to hold a free list link, and stay aligned within a slab
+    if (object_size < sizeof(uint32_t)) object_size = sizeof(uint32_t);
+    pool->object_size = (object_size + sizeof(max_align_t) - 1) / sizeof(max_align_t) * sizeof(max_align_t);
+    pool->slabs = NULL;
+    pool->slab_count = pool->slab_capacity = 0;
+    pool->free_list = POOL_NO_OBJECT;
+    pool->next_index = 0;
+
+    return pool;
+}
+
+/* The object with an index, which must have been handed out by pool_alloc */
+void* pool_object(pool_t *pool, uint32_t index) {
+    return pool->slabs[index / POOL_SLAB_OBJECTS] + (size_t)(index % POOL_SLAB_OBJECTS) * pool->object_size;
+}
+
+/* Reuses a freed object if there is one, otherwise takes the next one from the newest slab */
+void* pool_alloc(pool_t *pool, uint32_t *index) {
+    if (pool->free_list != POOL_NO_OBJECT) {
+        *index = pool->free_list;
+        void *object = pool_object(pool, *index);
+        memcpy(&pool->free_list, object, sizeof(uint32_t));
+        return object;
+    }
+
+    if (pool->next_index == (uint64_t)pool->slab_count * POOL_SLAB_OBJECTS) {
+        assert(pool->slab_count < POOL_NO_OBJECT / POOL_SLAB_OBJECTS);
+        if (pool->slab_count == pool->slab_capacity) {
+            pool->slab_capacity = pool->slab_capacity ? 2 * pool->slab_capacity : SLAB_TABLE_INITIAL_CAPACITY;
+            pool->slabs = realloc(pool->slabs, pool->slab_capacity * sizeof(char *));
+            assert(pool->slabs!=NULL);
+        }
+        pool->slabs[pool->slab_count] = malloc(POOL_SLAB_OBJECTS * pool->object_size);
+        assert(pool->slabs[pool->slab_count]!=NULL);
+        pool->slab_count++;
+    }
+
+    *index = pool->next_index++;
+    return pool_object(pool, *index);
+}
+
+void pool_free(pool_t *pool, uint32_t index) {
+    memcpy(pool_object(pool, index), &pool->free_list, sizeof(uint32_t));
+    pool->free_list = index;
+}
+
+/* Releases every slab, including objects that were never returned to the pool */
+void free_pool(pool_t *pool) {
+    for (uint32_t i = 0; i < pool->slab_count; i++) free(pool->slabs[i]);
+    free(pool->slabs);
+    free(pool);
+}
+
+arena_t* make_arena() {
+    arena_t *arena = malloc(sizeof(arena_t));
+    assert(arena!=NULL);
+
+    arena->chunks = NULL;
+    arena->live = NULL;
+    arena->chunk_capacity = 0;
+    arena->free_slots = NULL;
+    arena->free_slot_count = 0;
+    arena->current = 0;
+    arena->next_byte = arena->chunk_end = NULL;
+
+    return arena;
+}
+
+/* Gives a new chunk a slot, reusing that of a freed chunk if there is one */
+static uint32_t add_chunk(arena_t *arena, char *chunk) {
+    if (arena->free_slot_count) {
+        uint32_t slot = arena->free_slots[--arena->free_slot_count];
+        arena->chunks[slot] = chunk;
+        arena->live[slot] = 0;
+        return slot;
+    }
+
+    uint32_t slot = arena->chunk_capacity;
+    assert(slot < ARENA_MAX_CHUNKS);
+    arena->chunk_capacity = slot ? 2 * slot : CHUNK_TABLE_INITIAL_CAPACITY;
+    if (arena->chunk_capacity > ARENA_MAX_CHUNKS) arena->chunk_capacity = ARENA_MAX_CHUNKS;
+    arena->chunks = realloc(arena->chunks, arena->chunk_capacity * sizeof(char *));
+    arena->live = realloc(arena->live, arena->chunk_capacity * sizeof(int));
+    arena->free_slots = realloc(arena->free_slots, arena->chunk_capacity * sizeof(uint32_t));
+    assert(arena->chunks!=NULL && arena->live!=NULL && arena->free_slots!=NULL);
+
+    // the new slots above this one are handed out lowest first
+    for (uint32_t i = arena->chunk_capacity - 1; i > slot; i--) {
+        arena->chunks[i] = NULL;
+        arena->free_slots[arena->free_slot_count++] = i;
+    }
+    arena->chunks[slot] = chunk;
+    arena->live[slot] = 0;
+    return slot;
+}
+
+/* Copies length bytes of a string into the arena, starting a new chunk when the current one is
+   full. Returns its id, see ARENA_STRING */
+uint32_t arena_add_string(arena_t *arena, const char *s, size_t length) {
+    size_t bytes = (length + 1 + ARENA_ALIGN - 1) / ARENA_ALIGN * ARENA_ALIGN;
+
+    // every string in the current chunk has been released, so refill it from the start. A chunk
+    // made for a single long string is left full, offsets past ARENA_CHUNK_BYTES do not fit an id
+    char *chunk = arena->chunks ? arena->chunks[arena->current] : NULL;
+    if (chunk && arena->live[arena->current] == 0 && arena->chunk_end - chunk == ARENA_CHUNK_BYTES) {
+        arena->next_byte = chunk;
+    }
+
+    if (arena->chunk_end - arena->next_byte < (ptrdiff_t)bytes) {
+        // the chunk being left is freed by the release of its last string, or now if that has happened
+        if (chunk && arena->live[arena->current] == 0) {
+            free(chunk);
+            arena->chunks[arena->current] = NULL;
+            arena->free_slots[arena->free_slot_count++] = arena->current;
+        }
+
+        // a string longer than a chunk gets one of its own, at offset 0
+        size_t chunk_bytes = bytes > ARENA_CHUNK_BYTES ? bytes : ARENA_CHUNK_BYTES;
+        chunk = malloc(chunk_bytes);
+        assert(chunk!=NULL);
+        arena->current = add_chunk(arena, chunk);
+        arena->next_byte = chunk;
+        arena->chunk_end = chunk + chunk_bytes;
+    }
+
+    arena->live[arena->current]++;
+    uint32_t offset = (arena->next_byte - chunk) / ARENA_ALIGN;
+    assert(offset < (uint32_t)1 << ARENA_OFFSET_BITS);
+    memcpy(arena->next_byte, s, length);
+    arena->next_byte[length] = '\0';
+    arena->next_byte += bytes;
+    return (arena->current << ARENA_OFFSET_BITS) | offset;
+}
+
+/* Releases a string, freeing its chunk when it was the last live string in a full chunk */
+void arena_release(arena_t *arena, uint32_t id) {
+    uint32_t slot = id >> ARENA_OFFSET_BITS;
+
+    if (--arena->live[slot] > 0 || slot == arena->current) return;
+
+    free(arena->chunks[slot]);
+    arena->chunks[slot] = NULL;
+    arena->free_slots[arena->free_slot_count++] = slot;
+}
+
+void free_arena(arena_t *arena) {
+    for (uint32_t i = 0; i < arena->chunk_capacity; i++) free(arena->chunks[i]);
+    free(arena->chunks);
+    free(arena->live);
+    free(arena->free_slots);
+    free(arena);
+}
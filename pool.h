@@ -0,0 +1,56 @@
+#ifndef _POOL_H_
+#define _POOL_H_
+
+#include<stdlib.h>
+#include<stddef.h>
+#include<stdint.h>
+#include<string.h>
+#include<assert.h>
+
+#define POOL_SLAB_OBJECTS 1024
+#define POOL_NO_OBJECT UINT32_MAX
+#define ARENA_CHUNK_BYTES 65536
+#define ARENA_ALIGN 8
+#define ARENA_OFFSET_BITS 13    // ARENA_CHUNK_BYTES / ARENA_ALIGN offsets within a chunk
+#define ARENA_MAX_CHUNKS ((uint32_t)1 << (31 - ARENA_OFFSET_BITS))    // ids leave the top bit clear
+
+// the string with an id, NUL terminated
+#define ARENA_STRING(arena, id) ((const char *)(arena)->chunks[(id) >> ARENA_OFFSET_BITS] \
+    + (size_t)((id) & ((1 << ARENA_OFFSET_BITS) - 1)) * ARENA_ALIGN)
+
+// fixed-size object allocator, objects are carved out of slabs and recycled through a free list.
+// Every object also has a 32-bit index, which stays the same until it is freed
+typedef struct {
+    size_t object_size;
+    char **slabs;               // by index / POOL_SLAB_OBJECTS
+    uint32_t slab_count;
+    uint32_t slab_capacity;
+    uint32_t free_list;         // linked through the first 4 bytes of each free object
+    uint32_t next_index;        // unused objects in the newest slab start here
+} pool_t;
+
+// bump allocator for strings, a chunk is freed once every string in it has been released.
+// A string is named by a 32-bit id, its chunk's slot and its offset in the chunk
+typedef struct {
+    char **chunks;              // by slot, NULL for a free slot
+    int *live;                  // strings in each chunk not yet released
+    uint32_t chunk_capacity;
+    uint32_t *free_slots;
+    uint32_t free_slot_count;
+    uint32_t current;           // slot of the chunk being filled
+    char *next_byte;
+    char *chunk_end;
+} arena_t;
+
+pool_t* make_pool(size_t object_size);
+void* pool_alloc(pool_t *pool, uint32_t *index);
+void pool_free(pool_t *pool, uint32_t index);
+void* pool_object(pool_t *pool, uint32_t index);
+void free_pool(pool_t *pool);
+
+arena_t* make_arena();
+uint32_t arena_add_string(arena_t *arena, const char *s, size_t length);
+void arena_release(arena_t *arena, uint32_t id);
+void free_arena(arena_t *arena);
+
+#endif
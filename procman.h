@@ -0,0 +1,27 @@
+#ifndef _PROCMAN_H_
+#define _PROCMAN_H_
+
+// Embedding the simulator, link with libprocman.a -lm -pthread. A simulation_t holds all state
+// of one run and nothing is shared between runs, so independent simulations can run on as many
+// threads as there are, one thread to a simulation at a time:
+//
+//   config_t config = { SJF, BESTFIT, 3, EVENT, MEMORY_MB, MEMORY_GRANULARITY, 1 };
+//   writer_t *out = make_callback_writer(on_event, context, config.cpus);
+//   simulation_t *sim = make_simulation(&config, out);
+//   submit_process(sim, "P1", 0, 30, 16);      // in order of arrival
+//   advance_simulation(sim, 100);              // runs the cycles up to time 100
+//   submit_process(sim, "P2", 120, 10, 8);     // arriving after it
+//   schedule_processes(sim);                   // runs to the end and works out sim->results
+//   free_simulation(sim);
+//   free_writer(out);
+//
+// step_simulation runs one cycle at a time, and finish_simulation works out the results once it
+// returns 0. It returns -1, as do advance_simulation and schedule_processes, once the run cannot go
+// on, with the reason in sim->error, and the simulation can then only be freed. The library never
+// prints or exits itself. A process arriving no later than the last cycle run is refused. Events
+// are handed to the callback as binary log records, see output.h, with the name of the process for
+// READY, RUNNING and FINISHED. make_writer gives text or a binary log on a file descriptor instead,
+// and DISCARD keeps only the results
+#include"allocate.h"
+
+#endif
@@ -1,143 +1,208 @@
 #include"queues.h"
 
-int is_process_finished(process_t *p) {
-    return p->time_ran >= p->service_time;
+#define GROW(array, capacity) do { \
+        (array) = realloc((array), (capacity) * sizeof(*(array))); \
+        assert((array)!=NULL); \
+    } while (0)
+
+/* A process' name, name_length long. Only names in the arena are NUL terminated */
+const char* process_name(process_table_t *table, handle_t p) {
+    uint32_t name = table->name[p];
+    if (name & NAME_IN_MAP) return table->name_map + (name & ~NAME_IN_MAP);
+    return ARENA_STRING(table->name_arena, name);
+}
+
+int is_process_finished(process_table_t *table, handle_t p) {
+    return table->time_ran[p] >= table->service_time[p];
 }
 
 /* Adds remainder wait time if submitted before a quantum multiple */
-void increment_wait_time(process_t *p, int quantum) {
-    if (p->time_arrived > 0) {
-        int time = quantum - (p->time_arrived % quantum);
+void increment_wait_time(process_table_t *table, handle_t p, int quantum) {
+    if (table->time_arrived[p] > 0) {
+        int time = quantum - (int)(table->time_arrived[p] % quantum);
         if (time != quantum) {
-            p->wait_time += time;
+            table->wait_time[p] += time;
         }
     }
 }
 
-int process_remaining_time(process_t *p) {
-    return p->service_time - p->time_ran;
+/* Records the time a process starts waiting in input_q or ready_q */
+void start_waiting(process_table_t *table, handle_t p, int64_t time) {
+    table->wait_time[p] -= time;
 }
 
+/* Charges the time spent waiting since start_waiting when the process is scheduled */
+void stop_waiting(process_table_t *table, handle_t p, int64_t time) {
+    table->wait_time[p] += time;
+}
 
-/* Creates a new process, and assigns input data to variables */
-process_t* build_process(char *lineptr, char *delim) {
-    process_t *p = make_empty_process();
-    char *lineptr2 = lineptr;
+int64_t process_remaining_time(process_table_t *table, handle_t p) {
+    return table->service_time[p] - table->time_ran[p];
+}
 
-    p->time_arrived = atoi(strsep(&lineptr2, delim));
-    p->process_name = strdup(strsep(&lineptr2, delim));
-    p->service_time = atoi(strsep(&lineptr2, delim));
-    p->memory_requirement = atoi(strsep(&lineptr2, delim));
 
+process_table_t* make_process_table() {
+    process_table_t *table = calloc(1, sizeof(process_table_t));
+    assert(table!=NULL);
+    table->free_list = NO_PROCESS;
+    return table;
+}
 
-    return p;
+void free_process_table(process_table_t *table) {
+    free(table->id);
+    free(table->time_arrived);
+    free(table->service_time);
+    free(table->memory_requirement);
+    free(table->time_ran);
+    free(table->wait_time);
+    free(table->state);
+    free(table->level);
+    free(table->slice_used);
+    free(table->mem_start);
+    free(table->next);
+    free(table->name);
+    free(table->name_length);
+    free(table->segment);
+    free(table);
 }
 
-process_t* make_empty_process() {
-    process_t *p = malloc(sizeof(process_t));
-    assert(p != NULL);
+/* Doubles every array, threading the new slots onto the free list */
+static void grow_process_table(process_table_t *table) {
+    uint32_t old_capacity = table->capacity;
+    uint32_t capacity = old_capacity ? 2 * old_capacity : PROCESS_TABLE_INITIAL_CAPACITY;
+
+    GROW(table->id, capacity);
+    GROW(table->time_arrived, capacity);
+    GROW(table->service_time, capacity);
+    GROW(table->memory_requirement, capacity);
+    GROW(table->time_ran, capacity);
+    GROW(table->wait_time, capacity);
+    GROW(table->state, capacity);
+    GROW(table->level, capacity);
+    GROW(table->slice_used, capacity);
+    GROW(table->mem_start, capacity);
+    GROW(table->next, capacity);
+    GROW(table->name, capacity);
+    GROW(table->name_length, capacity);
+    GROW(table->segment, capacity);
+
+    for (uint32_t i = capacity; i > old_capacity; i--) {
+        table->next[i - 1] = table->free_list;
+        table->free_list = i - 1;
+    }
+    table->capacity = capacity;
+}
 
-    p->memory_requirement = 1;
-    p->process_name = NULL;
-    p->service_time = 0;
-    p->state = ARRIVED;
-    p->time_arrived = 0;
-    p->time_ran = 0;
-    p->wait_time = 0;
+handle_t make_empty_process(process_table_t *table) {
+    if (table->free_list == NO_PROCESS) grow_process_table(table);
+
+    handle_t p = table->free_list;
+    table->free_list = table->next[p];
+    table->count++;
+
+    table->id[p] = 0;
+    table->memory_requirement[p] = 1;
+    table->name[p] = 0;
+    table->name_length[p] = 0;
+    table->service_time[p] = 0;
+    table->state[p] = ARRIVED;
+    table->time_arrived[p] = 0;
+    table->time_ran[p] = 0;
+    table->wait_time[p] = 0;
+    table->segment[p] = NO_SEGMENT;
+    table->mem_start[p] = -1;
+    table->level[p] = 0;
+    table->slice_used[p] = 0;
+    table->next[p] = NO_PROCESS;
 
     return p;
 }
 
-void free_process(process_t *p) {
-    free(p->process_name);
-    p->process_name = NULL;
-    free(p);
+/* Takes the slots marked in live out of an empty table, so that a checkpoint's processes keep
+   their handles. The other slots up to capacity become free */
+void claim_process_slots(process_table_t *table, const uint8_t *live, uint32_t capacity) {
+    assert(table->count == 0);
+    while (table->capacity < capacity) grow_process_table(table);
+
+    table->free_list = NO_PROCESS;
+    for (uint32_t i = table->capacity; i > 0; i--) {
+        if (i - 1 < capacity && live[i - 1]) {
+            table->count++;
+            continue;
+        }
+        table->next[i - 1] = table->free_list;
+        table->free_list = i - 1;
+    }
+}
+
+/* Returns a process' slot to the table, its name is released by the trace */
+void free_process(process_table_t *table, handle_t p) {
+    table->next[p] = table->free_list;
+    table->free_list = p;
+    table->count--;
 }
 
-queue_t* make_empty_queue() {
+queue_t* make_empty_queue(process_table_t *table) {
     queue_t *q = malloc(sizeof(queue_t));
     assert(q!=NULL);
-    q->head = q->foot = NULL;
+    q->head = q->foot = NO_PROCESS;
     q->count = 0;
+    q->table = table;
 
     return q;
 }
 
-/* Adds node to queue by priority of remaining time - Shortest Job First */
-void enqueue_node_sjf(queue_t *q, node_t *n) {
-    assert(n!=NULL);    
-    node_t *prev = NULL, *curr = q->head;
+/* Enqueues a process to queue foot */
+void enqueue_process(queue_t *q, handle_t p) {
+    assert(p!=NO_PROCESS);
 
-    if (queue_is_empty(q)) {
-        enqueue_node(q, n);
-        return;
-    }
-
-    // Inserts a node inbetween nodes
-    while (curr) {
-        if (n->p->service_time < curr->p->service_time) {
-            if (prev == NULL) {
-                q->head = n;
-            } else {
-                prev->next = n;
-            }
-            n->next = curr;
-            q->count++;
-            return;
-        }
-        prev = curr;
-        curr = curr->next;
-    }
-    // Enqueue normally if reached end of queue
-    enqueue_node(q, n);
+    q->table->next[p] = NO_PROCESS;
+    q->count++;
+    if (q->foot==NO_PROCESS) q->head = q->foot = p;
+    else { q->table->next[q->foot] = p; q->foot = p;}
 }
 
-/* Enqueues node to queue foot */
-void enqueue_node(queue_t *q, node_t *n) {
-    assert(n!=NULL);
-    
-    q->count++;
-    if (q->foot==NULL) q->head = q->foot = n;
-    else { q->foot->next = n; q->foot = n;}
+/* Moves every process of from to the back of q, leaving from empty */
+void queue_append(queue_t *q, queue_t *from) {
+    if (queue_is_empty(from)) return;
+
+    if (q->foot != NO_PROCESS) q->table->next[q->foot] = from->head;
+    else q->head = from->head;
+    q->foot = from->foot;
+    q->count += from->count;
+
+    from->head = from->foot = NO_PROCESS;
+    from->count = 0;
 }
 
-node_t* dequeue_node(queue_t *q) {
-    node_t *n = q->head;
+/* Dequeues the head process, NO_PROCESS if the queue is empty */
+handle_t dequeue_process(queue_t *q) {
+    handle_t p = q->head;
 
-    if (n) {
-        q->head = n->next;
-        n->next = NULL;
+    if (p != NO_PROCESS) {
+        q->head = q->table->next[p];
+        q->table->next[p] = NO_PROCESS;
         q->count--;
     }
-    if (!q->head) {
-        q->foot = NULL;
+    if (q->head == NO_PROCESS) {
+        q->foot = NO_PROCESS;
     }
 
-    return n;
+    return p;
 }
 
-/* Enqueues a process into a queue by putting it inside a queue node */
-void enqueue_process(queue_t *q, process_t *p) {
-    node_t *new = malloc(sizeof(node_t));
-    assert(new!=NULL);
-    q->count++;
-    new->p = p;
-    new->next = NULL;
+/* Unlinks p from the queue in O(1) given the process before it, NO_PROCESS if p is the head */
+void queue_remove_after(queue_t *q, handle_t prev, handle_t p) {
+    handle_t next = q->table->next[p];
 
-    if (q->foot == NULL) {q->head = q->foot = new; }
-    else { q->foot->next = new; q->foot = new; }
-}
+    if (prev == NO_PROCESS) q->head = next;
+    else q->table->next[prev] = next;
+    if (q->foot == p) q->foot = prev;
 
-/* Dequeues head queue-node's process */
-process_t* dequeue_process(queue_t *q) {
-    process_t *p = q->head->p;
+    q->table->next[p] = NO_PROCESS;
     q->count--;
-    node_t *to_free = q->head;
-    q->head = q->head->next;
-    free(to_free);
-    return p;
 }
 
 int queue_is_empty(queue_t *q) {
-    return (q->head==NULL && q->count==0);
-}
\ No newline at end of file
+    return q->head==NO_PROCESS;
+}
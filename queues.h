@@ -9,49 +9,76 @@
 #include<assert.h>
 #include<limits.h>
 #include<math.h>
+#include"pool.h"
 
 #define ARRIVED -1
 #define READY 0
 #define RUNNING 1
 #define FINISHED 2
 
-typedef struct node node_t;
+#define NO_PROCESS UINT32_MAX
+#define NO_SEGMENT UINT32_MAX
+#define NAME_IN_MAP 0x80000000u     // a name with this bit set is an offset into name_map
+#define PROCESS_TABLE_INITIAL_CAPACITY 1024
 
+// index of a live process in the process table, recycled once the process has finished
+typedef uint32_t handle_t;
+
+// live processes as parallel arrays indexed by handle, the fields scheduling touches are
+// packed tightly and names and memory blocks are kept apart from them. A process takes 78 bytes
+// across the arrays, names and blocks are 32-bit references rather than pointers
 typedef struct {
-    uint32_t time_arrived; // first process always has time-arrived to 0
-    char *process_name;
-    uint32_t service_time;
-    int memory_requirement;
+    uint32_t capacity;
+    uint32_t count;             // live processes
+    handle_t free_list;         // finished processes' slots, linked through next
+
+    uint32_t *id;               // position in the trace
+    int64_t *time_arrived;      // first process always has time-arrived to 0
+    int64_t *service_time;
+    int64_t *memory_requirement;    // MB
+    int64_t *time_ran;
+    int64_t *wait_time;         // less the time it started waiting while it waits
+    int8_t *state;
+    uint8_t *level;             // MLFQ priority level, 0 is the highest
+    int64_t *slice_used;        // time run at that level
+    int64_t *mem_start;         // start in MB of the memory block held, -1 while it holds none
+    handle_t *next;             // next process in the same queue
+
+    uint32_t *name;             // in name_arena or name_map, see process_name
+    int *name_length;
+    uint32_t *segment;          // index of the memory block held under the segment list allocators
 
-    int time_ran;
-    int state;
-    int wait_time;
-} process_t;
+    arena_t *name_arena;        // set by the trace the processes come from
+    const char *name_map;       // and its mapping, if it is a mapped file
+} process_table_t;
 
+// FIFO of processes linked through the table's next array, a process is in one queue at a time
 typedef struct {
-    node_t *head;
-    node_t *foot;
+    handle_t head;
+    handle_t foot;
     int count;
+    process_table_t *table;
 } queue_t;
 
-struct node {
-    process_t *p;
-    node_t *next;
-};
+// Process table
+process_table_t* make_process_table();
+void free_process_table(process_table_t *table);
+handle_t make_empty_process(process_table_t *table);
+void free_process(process_table_t *table, handle_t p);
+void claim_process_slots(process_table_t *table, const uint8_t *live, uint32_t capacity);
 
 // Queues and processes
-int is_process_finished(process_t *p);
-void increment_wait_time(process_t *p, int quantum);
-int process_remaining_time(process_t *p);
-process_t* build_process(char *lineptr, char *delim);
-process_t* make_empty_process();
-void free_process(process_t *p);
-queue_t* make_empty_queue();
-void enqueue_node_sjf(queue_t *q, node_t *n);
-void enqueue_node(queue_t *q, node_t *n);
-node_t* dequeue_node(queue_t *q);
-void enqueue_process(queue_t *q, process_t *p);
-process_t* dequeue_process(queue_t *q);
+const char* process_name(process_table_t *table, handle_t p);
+int is_process_finished(process_table_t *table, handle_t p);
+void increment_wait_time(process_table_t *table, handle_t p, int quantum);
+void start_waiting(process_table_t *table, handle_t p, int64_t time);
+void stop_waiting(process_table_t *table, handle_t p, int64_t time);
+int64_t process_remaining_time(process_table_t *table, handle_t p);
+queue_t* make_empty_queue(process_table_t *table);
+void enqueue_process(queue_t *q, handle_t p);
+handle_t dequeue_process(queue_t *q);
+void queue_append(queue_t *q, queue_t *from);
+void queue_remove_after(queue_t *q, handle_t prev, handle_t p);
 int queue_is_empty(queue_t *q);
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,91 @@
+#include"ready.h"
+
+static const char *scheduler_names[SCHEDULER_COUNT] = { [SJF] = "SJF", [RR] = "RR", [MLFQ] = "MLFQ" };
+
+/* Scheduler named on the command line, -1 if there is none by that name */
+int parse_scheduler(const char *name) {
+    for (int i = 0; i < SCHEDULER_COUNT; i++) {
+        if (strcmp(scheduler_names[i], name) == 0) return i;
+    }
+    return -1;
+}
+
+const char* scheduler_name(int strategy) {
+    return scheduler_names[strategy];
+}
+
+/* levels and slices only matter to MLFQ */
+ready_q_t* make_ready_queue(int strategy, int levels, int64_t *slices, process_table_t *table) {
+    ready_q_t *rq = malloc(sizeof(ready_q_t));
+    assert(rq!=NULL);
+
+    rq->strategy = strategy;
+    rq->fifo = NULL;
+    rq->heap = NULL;
+    rq->mlfq = NULL;
+    rq->table = table;
+    if (strategy == SJF) rq->heap = make_empty_heap();
+    else if (strategy == MLFQ) rq->mlfq = make_mlfq(levels, slices, table);
+    else rq->fifo = make_empty_queue(table);
+
+    return rq;
+}
+
+void free_ready_queue(ready_q_t *rq) {
+    if (rq->heap) free_heap(rq->heap);
+    if (rq->mlfq) free_mlfq(rq->mlfq);
+    free(rq->fifo);
+    free(rq);
+}
+
+/* SJF orders by service time, ties in order of arrival to the ready queue; RR appends,
+   MLFQ to the queue of the process' level */
+void ready_enqueue_process(ready_q_t *rq, handle_t p) {
+    if (rq->strategy == SJF) heap_push_process(rq->heap, p, rq->table->service_time[p]);
+    else if (rq->strategy == MLFQ) mlfq_enqueue_process(rq->mlfq, p);
+    else enqueue_process(rq->fifo, p);
+}
+
+handle_t ready_dequeue_process(ready_q_t *rq) {
+    if (rq->strategy == SJF) return heap_pop_process(rq->heap);
+    if (rq->strategy == MLFQ) return mlfq_dequeue_process(rq->mlfq);
+    return dequeue_process(rq->fifo);
+}
+
+/* The process ready_dequeue_process would take next, NO_PROCESS if there is none */
+handle_t ready_peek_process(ready_q_t *rq) {
+    if (rq->strategy == SJF) return heap_peek_process(rq->heap);
+    if (rq->strategy == MLFQ) return mlfq_peek_process(rq->mlfq);
+    return rq->fifo->head;
+}
+
+int ready_count(ready_q_t *rq) {
+    if (rq->strategy == SJF) return rq->heap->count;
+    if (rq->strategy == MLFQ) return rq->mlfq->count;
+    return rq->fifo->count;
+}
+
+/* Copies the handles of the ready processes into processes, in no particular order, returns how many */
+int ready_processes(ready_q_t *rq, handle_t *processes) {
+    process_table_t *table = rq->table;
+    int count = 0;
+
+    if (rq->strategy == SJF) {
+        for (int i = 0; i < rq->heap->count; i++) processes[count++] = rq->heap->entries[i].p;
+    } else if (rq->strategy == MLFQ) {
+        for (int level = 0; level < rq->mlfq->levels; level++) {
+            for (handle_t p = rq->mlfq->queues[level]->head; p != NO_PROCESS; p = table->next[p]) {
+                processes[count++] = p;
+            }
+        }
+    } else {
+        for (handle_t p = rq->fifo->head; p != NO_PROCESS; p = table->next[p]) processes[count++] = p;
+    }
+    return count;
+}
+
+int ready_is_empty(ready_q_t *rq) {
+    if (rq->strategy == SJF) return heap_is_empty(rq->heap);
+    if (rq->strategy == MLFQ) return rq->mlfq->count == 0;
+    return queue_is_empty(rq->fifo);
+}
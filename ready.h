@@ -0,0 +1,37 @@
+#ifndef _READY_H_
+#define _READY_H_
+
+#include<stdlib.h>
+#include<string.h>
+#include<assert.h>
+#include"queues.h"
+#include"heap.h"
+#include"mlfq.h"
+
+#define SJF 0
+#define RR 1
+#define MLFQ 2
+#define SCHEDULER_COUNT 3
+
+// READY processes, a FIFO queue for RR, a heap on service time for SJF and a queue per
+// priority level for MLFQ
+typedef struct {
+    int strategy;
+    queue_t *fifo;
+    heap_t *heap;
+    mlfq_t *mlfq;
+    process_table_t *table;
+} ready_q_t;
+
+int parse_scheduler(const char *name);
+const char* scheduler_name(int strategy);
+ready_q_t* make_ready_queue(int strategy, int levels, int64_t *slices, process_table_t *table);
+void free_ready_queue(ready_q_t *rq);
+void ready_enqueue_process(ready_q_t *rq, handle_t p);
+handle_t ready_dequeue_process(ready_q_t *rq);
+handle_t ready_peek_process(ready_q_t *rq);
+int ready_count(ready_q_t *rq);
+int ready_processes(ready_q_t *rq, handle_t *processes);
+int ready_is_empty(ready_q_t *rq);
+
+#endif
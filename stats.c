@@ -0,0 +1,86 @@
+#include"stats.h"
+
+static const char *phase_names[PHASE_COUNT] = { "arrivals", "allocation", "scheduling", "accounting" };
+
+stats_t* make_stats(void) {
+    stats_t *stats = calloc(1, sizeof(stats_t));
+    assert(stats!=NULL);
+    stats->sample_stride = 1;
+    return stats;
+}
+
+void free_stats(stats_t *stats) {
+    free(stats);
+}
+
+/* Wall clock time in seconds */
+double stats_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Charges the time since start to a phase, and starts timing the next one */
+void stats_end_phase(stats_t *stats, int phase, double *start) {
+    double now = stats_now();
+    stats->phase_seconds[phase] += now - *start;
+    *start = now;
+}
+
+/* Whether this cycle's memory should be sampled, every sample_stride calls */
+int stats_sample_due(stats_t *stats) {
+    return stats->sample_calls++ % stats->sample_stride == 0;
+}
+
+void stats_sample_memory(stats_t *stats, int64_t time, int holes, int64_t hole_memory, int64_t largest_hole) {
+    // full, keep every other sample and sample half as often from now on
+    if (stats->sample_count == STATS_MAX_SAMPLES) {
+        for (int i = 0; i < STATS_MAX_SAMPLES / 2; i++) stats->samples[i] = stats->samples[2 * i];
+        stats->sample_count = STATS_MAX_SAMPLES / 2;
+        stats->sample_stride *= 2;
+    }
+
+    memory_sample_t *sample = &stats->samples[stats->sample_count++];
+    sample->time = time;
+    sample->holes = holes;
+    sample->hole_memory = hole_memory;
+    sample->largest_hole = largest_hole;
+}
+
+void write_stats_json(FILE *f, stats_t *stats) {
+    fprintf(f, "{\n");
+    fprintf(f, "  \"hole_searches\": %llu,\n", (unsigned long long)stats->hole_searches);
+    fprintf(f, "  \"segments_scanned\": %llu,\n", (unsigned long long)stats->segments_scanned);
+    fprintf(f, "  \"mean_segments_scanned\": %.3f,\n", stats->hole_searches
+        ? (double)stats->segments_scanned / stats->hole_searches : 0);
+    fprintf(f, "  \"max_segments_scanned\": %llu,\n", (unsigned long long)stats->max_segments_scanned);
+    fprintf(f, "  \"failed_admissions\": %llu,\n", (unsigned long long)stats->failed_admissions);
+    fprintf(f, "  \"skipped_admissions\": %llu,\n", (unsigned long long)stats->skipped_admissions);
+    fprintf(f, "  \"backfill_refusals\": %llu,\n", (unsigned long long)stats->backfill_refusals);
+    fprintf(f, "  \"input_queue_high_water\": %d,\n", stats->input_q_high_water);
+    fprintf(f, "  \"ready_queue_high_water\": %d,\n", stats->ready_q_high_water);
+    fprintf(f, "  \"max_holes\": %d,\n", stats->max_holes);
+    fprintf(f, "  \"context_switches\": %llu,\n", (unsigned long long)stats->context_switches);
+    fprintf(f, "  \"preemptions\": %llu,\n", (unsigned long long)stats->preemptions);
+    fprintf(f, "  \"steals\": %llu,\n", (unsigned long long)stats->steals);
+    fprintf(f, "  \"cycles\": %llu,\n", (unsigned long long)stats->cycles);
+    fprintf(f, "  \"idle_cycles\": %llu,\n", (unsigned long long)stats->idle_cycles);
+
+    fprintf(f, "  \"phase_seconds\": {");
+    for (int i = 0; i < PHASE_COUNT; i++) {
+        fprintf(f, "%s\"%s\": %.6f", i ? ", " : " ", phase_names[i], stats->phase_seconds[i]);
+    }
+    fprintf(f, " },\n");
+
+    // fragmentation is the share of free memory outside the largest hole
+    fprintf(f, "  \"memory_samples\": [");
+    for (int i = 0; i < stats->sample_count; i++) {
+        memory_sample_t *s = &stats->samples[i];
+        double fragmentation = s->hole_memory ? 1 - (double)s->largest_hole / s->hole_memory : 0;
+        fprintf(f, "%s\n    { \"time\": %lld, \"holes\": %d, \"free_mb\": %lld, \"largest_hole_mb\": %lld, "
+            "\"fragmentation\": %.4f }", i ? "," : "", (long long)s->time, s->holes, (long long)s->hole_memory,
+            (long long)s->largest_hole, fragmentation);
+    }
+    fprintf(f, "%s]\n", stats->sample_count ? "\n  " : "");
+    fprintf(f, "}\n");
+}
@@ -0,0 +1,73 @@
+#ifndef _STATS_H_
+#define _STATS_H_
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<stdint.h>
+#include<assert.h>
+#include<time.h>
+
+// Counters and timers for the hot paths of a simulation. They only exist when built
+// with make STATS=1 (-DPROCMAN_STATS), otherwise every STAT_ macro expands to nothing.
+
+#define PHASE_ARRIVALS 0
+#define PHASE_ALLOCATION 1
+#define PHASE_SCHEDULING 2
+#define PHASE_ACCOUNTING 3
+#define PHASE_COUNT 4
+
+// memory is sampled at most this many times, evenly spread over the run
+#define STATS_MAX_SAMPLES 1024
+
+typedef struct {
+    int64_t time;
+    int holes;
+    int64_t hole_memory;        // MB
+    int64_t largest_hole;
+} memory_sample_t;
+
+typedef struct {
+    uint64_t hole_searches;
+    uint64_t segments_scanned;      // segments, hole index nodes or buddy bitmap words visited
+    uint64_t max_segments_scanned;  // in a single search
+    uint64_t failed_admissions;     // input processes for which no hole was big enough
+    uint64_t skipped_admissions;    // input processes not retried as no hole could have grown for them
+    uint64_t backfill_refusals;     // input processes held back as they could delay the reservation
+    uint64_t context_switches;      // processes put on the CPU
+    uint64_t preemptions;           // RR switch outs
+    uint64_t steals;                // processes taken from another CPU's ready queue
+    uint64_t cycles;
+    uint64_t idle_cycles;           // cycles with nothing running
+    int input_q_high_water;
+    int ready_q_high_water;
+    int max_holes;
+    double phase_seconds[PHASE_COUNT];
+
+    memory_sample_t samples[STATS_MAX_SAMPLES];
+    int sample_count;
+    uint64_t sample_stride;         // doubles each time the samples fill up
+    uint64_t sample_calls;
+} stats_t;
+
+#ifdef PROCMAN_STATS
+#define STATS_ENABLED 1
+#define STAT_ONLY(...) __VA_ARGS__
+#define STAT_ADD(s, field, n) do { if (s) (s)->field += (n); } while (0)
+#define STAT_MAX(s, field, value) do { if ((s) && (value) > (s)->field) (s)->field = (value); } while (0)
+#else
+#define STATS_ENABLED 0
+#define STAT_ONLY(...)
+#define STAT_ADD(s, field, n) do { } while (0)
+#define STAT_MAX(s, field, value) do { } while (0)
+#endif
+#define STAT_DECLARE(declaration) STAT_ONLY(declaration)
+
+stats_t* make_stats(void);
+void free_stats(stats_t *stats);
+double stats_now(void);
+void stats_end_phase(stats_t *stats, int phase, double *start);
+int stats_sample_due(stats_t *stats);
+void stats_sample_memory(stats_t *stats, int64_t time, int holes, int64_t hole_memory, int64_t largest_hole);
+void write_stats_json(FILE *f, stats_t *stats);
+
+#endif
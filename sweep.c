@@ -0,0 +1,186 @@
+#include"sweep.h"
+
+typedef struct {
+    config_t config;
+    results_t results;
+    char error[SIMULATION_ERROR_BYTES];     // empty unless the run failed
+} sweep_run_t;
+
+// shared by the worker threads, only next_run changes once they start
+typedef struct {
+    trace_table_t *table;
+    sweep_run_t *runs;
+    int run_count;
+    int next_run;
+    pthread_mutex_t lock;
+} sweep_t;
+
+/* Parses a comma separated option value, names maps each accepted word to its value */
+static int parse_list(char *list, char *default_list, const char **names, int *values) {
+    char *copy = strdup(list ? list : default_list), *saveptr = NULL;
+    int count = 0;
+
+    for (char *item = strtok_r(copy, ",", &saveptr); item; item = strtok_r(NULL, ",", &saveptr)) {
+        if (count == MAX_SWEEP_VALUES) break;
+        if (!names) {
+            values[count++] = atoi(item);
+            continue;
+        }
+        int i;
+        for (i = 0; names[i] && strcmp(names[i], item) != 0; i++);
+        if (!names[i]) {
+            fprintf(stderr, "Unknown sweep value %s\n", item);
+            exit(EXIT_FAILURE);
+        }
+        values[count++] = i;
+    }
+
+    free(copy);
+    return count;
+}
+
+/* Parses a comma separated list of memory sizes into MB, the default if there is none */
+static int parse_sizes(char *list, int64_t default_mb, int64_t *values) {
+    if (!list) {
+        values[0] = default_mb;
+        return 1;
+    }
+
+    char *copy = strdup(list), *saveptr = NULL;
+    int count = 0;
+
+    for (char *item = strtok_r(copy, ",", &saveptr); item; item = strtok_r(NULL, ",", &saveptr)) {
+        if (count == MAX_SWEEP_VALUES) break;
+        int64_t bytes = parse_memory_size(item);
+        if (bytes < ((int64_t)1 << 20) || bytes % ((int64_t)1 << 20)) {
+            fprintf(stderr, "Unknown sweep value %s\n", item);
+            exit(EXIT_FAILURE);
+        }
+        values[count++] = bytes >> 20;
+    }
+
+    free(copy);
+    return count;
+}
+
+/* Worker thread, runs configurations until there are none left */
+static void* sweep_worker(void *arg) {
+    sweep_t *sweep = arg;
+    writer_t *out = make_writer(-1, DISCARD, 1);
+
+    while (1) {
+        pthread_mutex_lock(&sweep->lock);
+        int i = sweep->next_run++;
+        pthread_mutex_unlock(&sweep->lock);
+        if (i >= sweep->run_count) break;
+
+        simulation_t *sim = make_simulation(&sweep->runs[i].config, out);
+        sim->trace = open_table_trace(sweep->table, sim->processes);
+        sweep->runs[i].error[0] = '\0';
+        if (schedule_processes(sim) != 0) strcpy(sweep->runs[i].error, sim->error);
+        sweep->runs[i].results = sim->results;
+        free_simulation(sim);
+    }
+
+    free_writer(out);
+    return NULL;
+}
+
+/* Parses the trace once and simulates every combination of the given options, one
+   configuration at a time per thread, then prints one line of statistics per configuration */
+int run_sweep(char *filename, char *strategies, char *memory_strategies, char *quanta, 
+    char *memory_sizes, config_t *base, int threads) {
+    const char *strategy_names[SCHEDULER_COUNT + 1] = { NULL };
+    const char *memory_names[MEMORY_STRATEGY_COUNT + 1] = { NULL };
+    int strategy_values[MAX_SWEEP_VALUES], memory_values[MAX_SWEEP_VALUES];
+    int quantum_values[MAX_SWEEP_VALUES];
+    int64_t size_values[MAX_SWEEP_VALUES];
+
+    for (int i = 0; i < SCHEDULER_COUNT; i++) strategy_names[i] = scheduler_name(i);
+    for (int i = 0; i < MEMORY_STRATEGY_COUNT; i++) memory_names[i] = memory_strategy_name(i);
+    int strategy_count = parse_list(strategies, "SJF,RR", strategy_names, strategy_values);
+    int memory_count = parse_list(memory_strategies, "infinite,best-fit", memory_names, memory_values);
+    int quantum_count = parse_list(quanta, "1,2,3", NULL, quantum_values);
+    int size_count = parse_sizes(memory_sizes, base->memory_mb, size_values);
+    for (int q = 0; q < quantum_count; q++) {
+        if (quantum_values[q] < 1) {
+            fprintf(stderr, "Quantum must be at least 1\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    sweep_t sweep;
+    char error[TRACE_ERROR_BYTES] = "Input file error";
+    sweep.table = filename ? load_trace_table(filename, error) : NULL;
+    if (sweep.table == NULL) {
+        fprintf(stderr, "%s\n", error);
+        exit(EXIT_FAILURE);
+    }
+
+    sweep.run_count = strategy_count * memory_count * quantum_count * size_count;
+    sweep.runs = malloc(sweep.run_count * sizeof(sweep_run_t));
+    assert(sweep.runs!=NULL);
+    sweep.next_run = 0;
+    pthread_mutex_init(&sweep.lock, NULL);
+
+    int run = 0;
+    for (int s = 0; s < strategy_count; s++) {
+        for (int m = 0; m < memory_count; m++) {
+            for (int q = 0; q < quantum_count; q++) {
+                for (int z = 0; z < size_count; z++) {
+                    // everything not swept over comes from the command line
+                    config_t config = *base;
+                    config.strategy = strategy_values[s];
+                    config.memory_strategy = memory_values[m];
+                    config.quantum = quantum_values[q];
+                    config.memory_mb = size_values[z];
+                    if (allocator_pages(config.memory_strategy) && config.memory_mb > MAX_PAGED_MEMORY_MB) {
+                        fprintf(stderr, "Paged memory can be at most %lldMB\n", (long long)MAX_PAGED_MEMORY_MB);
+                        exit(EXIT_FAILURE);
+                    }
+                    if ((config.memory_mb << 20) % config.granularity) {
+                        fprintf(stderr, "Memory size %lldMB is not a multiple of the granularity\n",
+                            (long long)config.memory_mb);
+                        exit(EXIT_FAILURE);
+                    }
+                    sweep.runs[run++].config = config;
+                }
+            }
+        }
+    }
+
+    if (threads <= 0) threads = sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads > sweep.run_count) threads = sweep.run_count;
+    if (threads < 1) threads = 1;
+
+    pthread_t *workers = malloc(threads * sizeof(pthread_t));
+    assert(workers!=NULL);
+    for (int i = 0; i < threads; i++) pthread_create(&workers[i], NULL, sweep_worker, &sweep);
+    for (int i = 0; i < threads; i++) pthread_join(workers[i], NULL);
+
+    // a run that failed gets a row without statistics, and the reason on stderr
+    int failed = 0;
+    printf("scheduler,memory,quantum,memory_mb,turnaround,max_overhead,average_overhead,makespan\n");
+    for (int i = 0; i < sweep.run_count; i++) {
+        config_t *c = &sweep.runs[i].config;
+        results_t *r = &sweep.runs[i].results;
+        printf("%s,%s,%d,%lld,", strategy_names[c->strategy], memory_names[c->memory_strategy], c->quantum,
+            (long long)c->memory_mb);
+        if (sweep.runs[i].error[0]) {
+            printf(",,,\n");
+            fprintf(stderr, "%s,%s,%d,%lld: %s\n", strategy_names[c->strategy], memory_names[c->memory_strategy],
+                c->quantum, (long long)c->memory_mb, sweep.runs[i].error);
+            failed = 1;
+            continue;
+        }
+        printf("%.0f,%.2f,%.2f,%lld\n", r->turnaround, r->max_overhead, r->average_overhead,
+            (long long)r->makespan);
+    }
+
+    free(workers);
+    free(sweep.runs);
+    pthread_mutex_destroy(&sweep.lock);
+    free_trace_table(sweep.table);
+
+    return failed ? EXIT_FAILURE : 0;
+}
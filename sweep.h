@@ -0,0 +1,16 @@
+#ifndef _SWEEP_H_
+#define _SWEEP_H_
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<pthread.h>
+#include<unistd.h>
+#include"allocate.h"
+
+#define MAX_SWEEP_VALUES 64
+
+int run_sweep(char *filename, char *strategies, char *memory_strategies, char *quanta, 
+     char *memory_sizes, config_t *base, int threads);
+
+#endif
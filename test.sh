@@ -0,0 +1,78 @@
+#!/bin/sh
+# make test: runs every case in tests/runs and compares its output with tests/expected, then runs
+# the sample traces and a few generated ones under every scheduler and a spread of memory
+# strategies, and checks that
+#   - a run restored from a checkpoint prints what the uninterrupted run prints after it
+#   - -a tick and -a event print the same
+#   - the binary log decodes to the text output
+
+dir=$(mktemp -d) || exit 1
+trap 'rm -rf "$dir"' EXIT
+
+failures=0
+fail() {
+    echo "FAIL $*"
+    failures=$((failures + 1))
+}
+
+# each line names an expected output and gives the arguments that print it
+while read -r name args; do
+    case "$name" in ''|'#'*) continue ;; esac
+    ./allocate $args > "$dir/out" 2>&1
+    cmp -s "$dir/out" "tests/expected/$name.txt" || fail "$name: differs from tests/expected/$name.txt"
+done < tests/runs
+
+traces="case1.txt case2.txt case3.txt"
+for seed in 1 2 3; do
+    ./gentrace -n 200 -S $seed -g 2 -M 1500 > "$dir/gen$seed.txt" || exit 1
+    traces="$traces $dir/gen$seed.txt"
+done
+
+for trace in $traces; do
+    for strategy in SJF RR MLFQ; do
+        for memory in infinite best-fit next-fit buddy paged virtual; do
+            for cpus in 1 2; do
+                run="$trace -s $strategy -m $memory -q 3 -c $cpus"
+                ./allocate -f $trace -s $strategy -m $memory -q 3 -c $cpus > "$dir/event" || { fail "$run"; continue; }
+
+                ./allocate -f $trace -s $strategy -m $memory -q 3 -c $cpus -a tick > "$dir/tick" || fail "$run -a tick"
+                cmp -s "$dir/event" "$dir/tick" || fail "$run: -a tick differs from -a event"
+
+                ./allocate -f $trace -s $strategy -m $memory -q 3 -c $cpus -o binary | ./decode > "$dir/decoded"
+                cmp -s "$dir/event" "$dir/decoded" || fail "$run: decode differs from -o text"
+
+                # checkpoint halfway through, the restored run prints the rest of the output
+                half=$(awk '/^Makespan/ { print int($2 / 2) }' "$dir/event")
+                ./allocate -f $trace -s $strategy -m $memory -q 3 -c $cpus --checkpoint-at $half "$dir/checkpoint" \
+                    > /dev/null || { fail "$run --checkpoint-at $half"; continue; }
+                ./allocate -f $trace --restore "$dir/checkpoint" > "$dir/restored" || { fail "$run --restore"; continue; }
+                lines=$(wc -l < "$dir/restored")
+                tail -n $lines "$dir/event" | cmp -s - "$dir/restored" || fail "$run: restore at $half differs"
+            done
+        done
+    done
+done
+
+# stdin is sorted from the line read ahead on, as the file would be, and a line arriving before a
+# process that has already arrived stops the run
+printf '0 A 3 1\n10 B 2 1\n4 C 2 1\n3 D 1 1\n' > "$dir/unsorted.txt"
+./allocate -f "$dir/unsorted.txt" -s RR -q 1 > "$dir/event" 2>&1
+cat "$dir/unsorted.txt" | ./allocate -f - -s RR -q 1 > "$dir/streamed" 2>&1
+cmp -s "$dir/event" "$dir/streamed" || fail "unsorted stdin: differs from the file"
+printf '5 A 1 1\n6 B 1 1\n0 C 1 1\n' | ./allocate -f - -s RR -q 1 > "$dir/streamed" 2>&1 && fail "late stdin line: ran"
+grep -q '^stdin:3: arrives at 0' "$dir/streamed" || fail "late stdin line: not reported"
+
+# a name longer than the output buffer is written straight through, in both formats
+awk 'BEGIN { name = "P"; while (length(name) < 1500000) name = name name; print "0 " name " 3 10"; print "1 P2 2 10" }' \
+    > "$dir/longname.txt"
+./allocate -f "$dir/longname.txt" -s RR -q 1 > "$dir/event" || fail "longname"
+[ "$(cut -c1-12 "$dir/event" | head -n 1)" = "0,RUNNING,pr" ] && [ "$(head -n 1 "$dir/event" | tail -c 18)" = ",remaining_time=3" ] \
+    || fail "longname: first line is not a whole event"
+./allocate -f "$dir/longname.txt" -s RR -q 1 -o binary | ./decode > "$dir/decoded"
+cmp -s "$dir/event" "$dir/decoded" || fail "longname: decode differs from -o text"
+
+if [ $failures -ne 0 ]; then
+    echo "$failures failed"
+    exit 1
+fi
+echo "All tests passed"
@@ -0,0 +1,101 @@
+#include<time.h>
+#include<pthread.h>
+#include"procman.h"
+
+// Simulations per second through the library, many small simulations run on each of a number
+// of threads, each with its processes submitted through the API and its events counted by a
+// callback. One CSV row per thread count.
+// usage: ./throughput <simulations> <processes> <threads>... > throughput.csv
+
+typedef struct {
+    int first;                  // index of its first simulation
+    int count;
+    int processes;
+    uint64_t events;
+} worker_t;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void count_event(void *context, const event_record_t *record, const char *name, int name_length) {
+    (*(uint64_t *)context)++;
+}
+
+/* Runs one simulation, its configuration and processes follow from its index alone */
+static void run_simulation(worker_t *worker, int index, uint64_t *events) {
+    uint32_t seed = index * 2654435761u + 1;
+    config_t config = { index % SCHEDULER_COUNT, index / SCHEDULER_COUNT % MEMORY_STRATEGY_COUNT, 1 + index % 3,
+        EVENT, MEMORY_MB, MEMORY_GRANULARITY, 1 };
+    writer_t *out = make_callback_writer(count_event, events, config.cpus);
+    simulation_t *sim = make_simulation(&config, out);
+
+    char name[16];
+    int64_t arrival = 0;
+    for (int i = 0; i < worker->processes; i++) {
+        seed = seed * 1103515245 + 12345;
+        arrival += seed >> 28;
+        snprintf(name, sizeof(name), "P%d", i);
+        submit_process(sim, name, arrival, 1 + (seed >> 8) % 100, 1 + (seed >> 16) % 512);
+    }
+
+    schedule_processes(sim);
+    free_simulation(sim);
+    free_writer(out);
+}
+
+static void* throughput_worker(void *arg) {
+    worker_t *worker = arg;
+
+    // counted locally, the workers sit next to each other and would share cache lines
+    uint64_t events = 0;
+    for (int i = 0; i < worker->count; i++) run_simulation(worker, worker->first + i, &events);
+    worker->events = events;
+    return NULL;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 4 || atoi(argv[1]) < 1 || atoi(argv[2]) < 1) {
+        fprintf(stderr, "usage: %s simulations processes threads...\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+    int simulations = atoi(argv[1]), processes = atoi(argv[2]);
+
+    printf("threads,simulations,processes,seconds,simulations_per_second,events\n");
+    for (int i = 3; i < argc; i++) {
+        int threads = atoi(argv[i]);
+        if (threads < 1) threads = 1;
+
+        pthread_t *threads_run = malloc(threads * sizeof(pthread_t));
+        worker_t *workers = malloc(threads * sizeof(worker_t));
+        assert(threads_run!=NULL && workers!=NULL);
+
+        // the simulations are split evenly, the same ones whatever the number of threads
+        double start = now_seconds();
+        for (int t = 0; t < threads; t++) {
+            workers[t].first = (int64_t)simulations * t / threads;
+            workers[t].count = (int64_t)simulations * (t + 1) / threads - workers[t].first;
+            workers[t].processes = processes;
+            workers[t].events = 0;
+            pthread_create(&threads_run[t], NULL, throughput_worker, &workers[t]);
+        }
+
+        uint64_t events = 0;
+        for (int t = 0; t < threads; t++) {
+            pthread_join(threads_run[t], NULL);
+            events += workers[t].events;
+        }
+        double seconds = now_seconds() - start;
+
+        printf("%d,%d,%d,%.6f,%.1f,%llu\n", threads, simulations, processes, seconds,
+            simulations / seconds, (unsigned long long)events);
+        fflush(stdout);
+
+        free(threads_run);
+        free(workers);
+    }
+
+    return 0;
+}
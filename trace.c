@@ -0,0 +1,499 @@
+#include"trace.h"
+
+#define PENDING_INITIAL_CAPACITY 1024
+#define TABLE_INITIAL_CAPACITY 1024
+#define FNV_OFFSET 14695981039346656037ULL
+#define FNV_PRIME 1099511628211ULL
+
+static handle_t read_trace_line(trace_t *trace);
+static void start_trace(trace_t *trace);
+static void read_ahead(trace_t *trace);
+static void sort_rest_of_trace(trace_t *trace);
+static int map_trace(trace_t *trace, FILE *file);
+
+static trace_t* make_trace(char *filename, process_table_t *processes, arena_t *name_arena) {
+    trace_t *trace = malloc(sizeof(trace_t));
+    assert(trace!=NULL);
+
+    trace->filename = filename;
+    trace->line_number = 0;
+    trace->process_count = 0;
+    trace->map = trace->map_cursor = NULL;
+    trace->map_length = 0;
+    trace->file = NULL;
+    trace->lineptr = NULL;
+    trace->line_buffer_length = 0;
+    trace->table = NULL;
+    trace->table_next = 0;
+    trace->submitted = NULL;
+    trace->next = trace->after = NO_PROCESS;
+    trace->last_arrival = trace->handed_out_arrival = 0;
+    trace->next_text = trace->after_text = trace->read_text = trace->consumed = (trace_line_t){ FNV_OFFSET, 0 };
+    trace->unsorted = 0;
+    trace->pending = NULL;
+    trace->pending_count = trace->pending_next = 0;
+    trace->processes = processes;
+    trace->name_arena = name_arena;
+    processes->name_arena = name_arena;
+    trace->error[0] = '\0';
+
+    return trace;
+}
+
+/* Opens a trace, "-" reads from stdin so that a trace can be piped in */
+trace_t* open_trace(char *filename, process_table_t *processes, arena_t *name_arena) {
+    FILE *file = strcmp(filename, "-") == 0 ? stdin : fopen(filename, "r");
+    if (file == NULL) return NULL;
+
+    trace_t *trace = make_trace(file == stdin ? "stdin" : filename, processes, name_arena);
+    trace->file = file;
+    if (map_trace(trace, file)) {
+        fclose(file);
+        trace->file = NULL;
+    }
+
+    start_trace(trace);
+    return trace;
+}
+
+/* Replays a loaded table, names are shared with the table */
+trace_t* open_table_trace(trace_table_t *table, process_table_t *processes) {
+    trace_t *trace = make_trace("table", processes, table->name_arena);
+    trace->table = table;
+
+    start_trace(trace);
+    return trace;
+}
+
+/* Starts out empty, processes are added with trace_submit_process and their names copied */
+trace_t* open_submitted_trace(process_table_t *processes, arena_t *name_arena) {
+    trace_t *trace = make_trace("submitted", processes, name_arena);
+    trace->submitted = make_empty_queue(processes);
+
+    return trace;
+}
+
+/* Adds a process behind those submitted before it, none of which may arrive after it.
+   Returns NO_PROCESS if one does */
+handle_t trace_submit_process(trace_t *trace, const char *name, int name_length, int64_t time_arrived,
+    int64_t service_time, int64_t memory_requirement) {
+    if (!trace->submitted || time_arrived < trace->last_arrival) return NO_PROCESS;
+
+    process_table_t *t = trace->processes;
+    handle_t p = make_empty_process(t);
+    t->id[p] = trace->process_count++;
+    t->time_arrived[p] = time_arrived;
+    t->name[p] = arena_add_string(trace->name_arena, name, name_length);
+    t->name_length[p] = name_length;
+    t->service_time[p] = service_time;
+    t->memory_requirement[p] = memory_requirement;
+
+    if (trace->next == NO_PROCESS) trace->next = p;
+    else enqueue_process(trace->submitted, p);
+    trace->last_arrival = time_arrived;
+
+    return p;
+}
+
+void close_trace(trace_t *trace) {
+    if (trace->map) {
+        munmap((void *)trace->map, trace->map_length);
+        trace->processes->name_map = NULL;
+    }
+    if (trace->file && trace->file != stdin) fclose(trace->file);
+    free(trace->lineptr);
+    free(trace->pending);
+    free(trace->submitted);
+    free(trace);
+}
+
+int trace_is_empty(trace_t *trace) {
+    return trace->next == NO_PROCESS;
+}
+
+/* Whether the processes had to be sorted by arrival time, the trace was not in order */
+int trace_was_sorted(trace_t *trace) {
+    return trace->unsorted;
+}
+
+/* The lines of the processes handed out so far, in the order they were. A checkpoint keeps
+   this to check that it is restored onto the trace it was taken from */
+trace_line_t trace_consumed(trace_t *trace) {
+    return trace->consumed;
+}
+
+static uint64_t hash_bytes(uint64_t hash, const char *s, size_t length) {
+    for (size_t i = 0; i < length; i++) hash = (hash ^ (unsigned char)s[i]) * FNV_PRIME;
+    return hash;
+}
+
+/* Adds a line to those handed out, its hash is hashed in so that the order counts */
+static void consume_line(trace_t *trace, trace_line_t text) {
+    trace->consumed.hash = hash_bytes(trace->consumed.hash, (const char *)&text.hash, sizeof(text.hash));
+    trace->consumed.length += text.length;
+}
+
+/* The line a submitted process would have in a trace file */
+static trace_line_t submitted_line(process_table_t *t, handle_t p) {
+    char fields[64];
+    int length = snprintf(fields, sizeof(fields), "%lld ", (long long)t->time_arrived[p]);
+    trace_line_t text = { hash_bytes(FNV_OFFSET, fields, length), length };
+
+    text.hash = hash_bytes(text.hash, process_name(t, p), t->name_length[p]);
+    text.length += t->name_length[p];
+    length = snprintf(fields, sizeof(fields), " %lld %lld\n", (long long)t->service_time[p],
+        (long long)t->memory_requirement[p]);
+    text.hash = hash_bytes(text.hash, fields, length);
+    text.length += length;
+    return text;
+}
+
+/* Why the trace ended early, NULL if it did not */
+const char* trace_error(trace_t *trace) {
+    return trace->error[0] ? trace->error : NULL;
+}
+
+/* Arrival time of the next process, INT64_MAX once the trace is exhausted */
+int64_t trace_next_arrival(trace_t *trace) {
+    return trace->next != NO_PROCESS ? trace->processes->time_arrived[trace->next] : INT64_MAX;
+}
+
+/* Hands out the next process and reads ahead the one after the new next */
+handle_t trace_next_process(trace_t *trace) {
+    handle_t p = trace->next;
+    if (p == NO_PROCESS) return NO_PROCESS;
+
+    if (trace->submitted) {
+        consume_line(trace, submitted_line(trace->processes, p));
+        trace->next = dequeue_process(trace->submitted);
+        return p;
+    }
+    consume_line(trace, trace->next_text);
+    trace->handed_out_arrival = trace->processes->time_arrived[p];
+    if (trace->unsorted) {
+        if (trace->pending_next < trace->pending_count) {
+            trace->next_text = trace->pending[trace->pending_next].text;
+            trace->next = trace->pending[trace->pending_next++].p;
+        } else {
+            trace->next = NO_PROCESS;
+        }
+        return p;
+    }
+
+    trace->next = trace->after;
+    trace->next_text = trace->after_text;
+    trace->after = NO_PROCESS;
+    if (trace->next != NO_PROCESS) read_ahead(trace);
+
+    return p;
+}
+
+/* Drops the first count processes of the trace, those a restored run had already read */
+void skip_trace_processes(trace_t *trace, int64_t count) {
+    for (int64_t i = 0; i < count && !trace_is_empty(trace); i++) {
+        release_process(trace, trace_next_process(trace));
+    }
+}
+
+/* Returns a finished process to the table and its name to the arena, if it was copied there */
+void release_process(trace_t *trace, handle_t p) {
+    uint32_t name = trace->processes->name[p];
+    if (!trace->table && !(name & NAME_IN_MAP)) arena_release(trace->name_arena, name);
+    free_process(trace->processes, p);
+}
+
+/* Maps a regular file into memory, returns 0 if the file has to be read line by line */
+static int map_trace(trace_t *trace, FILE *file) {
+    struct stat st;
+    int fd = fileno(file);
+
+    if (fstat(fd, &st) == -1 || !S_ISREG(st.st_mode) || st.st_size == 0) return 0;
+
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) return 0;
+    madvise(map, st.st_size, MADV_SEQUENTIAL);
+
+    trace->map = trace->map_cursor = map;
+    trace->map_length = st.st_size;
+    trace->processes->name_map = map;
+    return 1;
+}
+
+/* Finds the next line of the trace, returns 0 at the end of the input */
+static int next_trace_line(trace_t *trace, const char **start, const char **end) {
+    if (trace->map) {
+        const char *map_end = trace->map + trace->map_length;
+        if (trace->map_cursor == map_end) return 0;
+
+        const char *newline = memchr(trace->map_cursor, '\n', map_end - trace->map_cursor);
+        *start = trace->map_cursor;
+        *end = newline ? newline : map_end;
+        trace->map_cursor = newline ? newline + 1 : map_end;
+        trace->read_text.length = trace->map_cursor - *start;
+        return 1;
+    }
+
+    if (!trace->file) return 0;
+
+    ssize_t length = getline(&trace->lineptr, &trace->line_buffer_length, trace->file);
+    if (length == -1) {
+        if (trace->file != stdin) fclose(trace->file);
+        trace->file = NULL;
+        return 0;
+    }
+    *start = trace->lineptr;
+    *end = trace->lineptr + length;
+    trace->read_text.length = length;
+    return 1;
+}
+
+/* Ends the trace at a line that cannot be parsed, keeping why for trace_error */
+static handle_t malformed_line(trace_t *trace, const char *expected) {
+    snprintf(trace->error, sizeof(trace->error), "%s:%d: malformed line, expected %s", trace->filename,
+        trace->line_number, expected);
+    return NO_PROCESS;
+}
+
+/* Ends the trace at a line arriving before a process already handed out, which it would then
+   follow in the run rather than precede as it does in a sorted trace */
+static handle_t late_line(trace_t *trace, int64_t time_arrived) {
+    snprintf(trace->error, sizeof(trace->error), "%s:%d: arrives at %lld, earlier than a process that has "
+        "already arrived at %lld", trace->filename, trace->line_number, (long long)time_arrived,
+        (long long)trace->handed_out_arrival);
+    return NO_PROCESS;
+}
+
+static int is_blank(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static const char* skip_blanks(const char *s, const char *end) {
+    while (s < end && is_blank(*s)) s++;
+    return s;
+}
+
+/* Parses a decimal field that ends at a blank or the end of the line, NULL if it is not one */
+static const char* parse_field(const char *s, const char *end, int64_t *value) {
+    int64_t v = 0;
+    const char *digits = s;
+
+    while (s < end && *s >= '0' && *s <= '9') {
+        if (v > (INT64_MAX - (*s - '0')) / 10) return NULL;
+        v = v * 10 + (*s - '0');
+        s++;
+    }
+    if (s == digits || (s < end && !is_blank(*s))) return NULL;
+
+    *value = v;
+    return s;
+}
+
+/* Parses "arrival name service memory" into a new process, skipping blank lines */
+static handle_t read_trace_line(trace_t *trace) {
+    const char *s, *end;
+    int64_t time_arrived, service_time, memory_requirement;
+
+    if (trace->table) {
+        if (trace->table_next == trace->table->count) return NO_PROCESS;
+        process_spec_t *spec = &trace->table->processes[trace->table_next];
+        process_table_t *t = trace->processes;
+        handle_t p = make_empty_process(t);
+        t->id[p] = trace->table_next++;
+        t->time_arrived[p] = spec->time_arrived;
+        t->name[p] = spec->name;
+        t->name_length[p] = spec->name_length;
+        t->service_time[p] = spec->service_time;
+        t->memory_requirement[p] = spec->memory_requirement;
+        trace->read_text = spec->text;
+        return p;
+    }
+
+    if (trace->error[0]) return NO_PROCESS;
+
+    const char *line;
+    do {
+        if (!next_trace_line(trace, &line, &end)) return NO_PROCESS;
+        trace->line_number++;
+        s = skip_blanks(line, end);
+    } while (s == end);
+    trace->read_text.hash = hash_bytes(FNV_OFFSET, line, trace->read_text.length);
+
+    if (!(s = parse_field(s, end, &time_arrived))) {
+        return malformed_line(trace, "an arrival time");
+    }
+
+    const char *name = s = skip_blanks(s, end);
+    while (s < end && !is_blank(*s)) s++;
+    if (s == name) return malformed_line(trace, "a process name");
+    int name_length = s - name;
+
+    if (!(s = parse_field(skip_blanks(s, end), end, &service_time))) {
+        return malformed_line(trace, "a service time");
+    }
+    if (!(s = parse_field(skip_blanks(s, end), end, &memory_requirement))) {
+        return malformed_line(trace, "a memory requirement");
+    }
+    if (skip_blanks(s, end) != end) return malformed_line(trace, "four fields");
+    if (time_arrived < trace->handed_out_arrival) return late_line(trace, time_arrived);
+
+    process_table_t *t = trace->processes;
+    handle_t p = make_empty_process(t);
+    t->id[p] = trace->process_count++;
+    t->time_arrived[p] = time_arrived;
+    // a mapped trace's names are referred to where they are, unless too far in for an id
+    if (trace->map && (size_t)(name - trace->map) < NAME_IN_MAP) {
+        t->name[p] = NAME_IN_MAP | (uint32_t)(name - trace->map);
+    } else {
+        t->name[p] = arena_add_string(trace->name_arena, name, name_length);
+    }
+    t->name_length[p] = name_length;
+    t->service_time[p] = service_time;
+    t->memory_requirement[p] = memory_requirement;
+
+    return p;
+}
+
+/* Whether the arrival times of a mapped trace never go down, up to its first malformed line */
+static int map_is_sorted(trace_t *trace) {
+    const char *line = trace->map, *map_end = trace->map + trace->map_length;
+    int64_t last_arrival = 0, time_arrived;
+
+    while (line < map_end) {
+        const char *newline = memchr(line, '\n', map_end - line);
+        const char *end = newline ? newline : map_end;
+        const char *s = skip_blanks(line, end);
+        line = newline ? newline + 1 : map_end;
+
+        if (s == end) continue;
+        if (!parse_field(s, end, &time_arrived)) break;
+        if (time_arrived < last_arrival) return 0;
+        last_arrival = time_arrived;
+    }
+    return 1;
+}
+
+/* Reads the first processes. A mapped trace is checked before any process is handed out and
+   sorted at once if it is out of order. Other input is checked as it is read, one process ahead
+   of the next to be handed out */
+static void start_trace(trace_t *trace) {
+    int sorted = !trace->map || map_is_sorted(trace);
+    trace->next = read_trace_line(trace);
+    if (trace->next == NO_PROCESS) return;
+    trace->next_text = trace->read_text;
+
+    if (sorted) read_ahead(trace);
+    else sort_rest_of_trace(trace);
+}
+
+/* Reads the process after next, the rest of the trace is sorted if it arrives before next */
+static void read_ahead(trace_t *trace) {
+    trace->after = read_trace_line(trace);
+    trace->after_text = trace->read_text;
+    if (trace->after != NO_PROCESS
+        && trace->processes->time_arrived[trace->after] < trace->processes->time_arrived[trace->next]) {
+        sort_rest_of_trace(trace);
+    }
+}
+
+static int compare_arrival(const void *a, const void *b) {
+    const pending_process_t *p = a, *q = b;
+    if (p->time_arrived != q->time_arrived) return p->time_arrived < q->time_arrived ? -1 : 1;
+    // keep input order among equal arrival times
+    return p->line - q->line;
+}
+
+/* The input is not in arrival order: read in the remaining processes, from next on, and sort them */
+static void sort_rest_of_trace(trace_t *trace) {
+    int capacity = PENDING_INITIAL_CAPACITY;
+    trace->pending = malloc(capacity * sizeof(pending_process_t));
+    assert(trace->pending!=NULL);
+
+    handle_t p = trace->next, after = trace->after;
+    trace_line_t text = trace->next_text;
+    trace->after = NO_PROCESS;
+    while (p != NO_PROCESS) {
+        if (trace->pending_count == capacity) {
+            capacity *= 2;
+            trace->pending = realloc(trace->pending, capacity * sizeof(pending_process_t));
+            assert(trace->pending!=NULL);
+        }
+        trace->pending[trace->pending_count].p = p;
+        trace->pending[trace->pending_count].time_arrived = trace->processes->time_arrived[p];
+        trace->pending[trace->pending_count].line = trace->pending_count;
+        trace->pending[trace->pending_count].text = text;
+        trace->pending_count++;
+        if (after != NO_PROCESS) {
+            p = after;
+            text = trace->after_text;
+            after = NO_PROCESS;
+        } else {
+            p = read_trace_line(trace);
+            text = trace->read_text;
+        }
+    }
+
+    qsort(trace->pending, trace->pending_count, sizeof(pending_process_t), compare_arrival);
+
+    trace->unsorted = 1;
+    trace->next_text = trace->pending[trace->pending_next].text;
+    trace->next = trace->pending[trace->pending_next++].p;
+}
+
+/* Parses a whole trace into a table, sorted by arrival time. Returns NULL with the reason
+   written to error, TRACE_ERROR_BYTES long, if the trace cannot be read or parsed */
+trace_table_t* load_trace_table(char *filename, char *error) {
+    process_table_t *processes = make_process_table();
+    arena_t *name_arena = make_arena();
+    trace_t *trace = open_trace(filename, processes, name_arena);
+    if (trace == NULL) {
+        snprintf(error, TRACE_ERROR_BYTES, "Input file error");
+        free_process_table(processes);
+        free_arena(name_arena);
+        return NULL;
+    }
+
+    trace_table_t *table = malloc(sizeof(trace_table_t));
+    assert(table!=NULL);
+    int capacity = TABLE_INITIAL_CAPACITY;
+    table->processes = malloc(capacity * sizeof(process_spec_t));
+    assert(table->processes!=NULL);
+    table->count = 0;
+    table->name_arena = make_arena();
+
+    while (!trace_is_empty(trace)) {
+        trace_line_t text = trace->next_text;
+        handle_t p = trace_next_process(trace);
+        if (table->count == capacity) {
+            capacity *= 2;
+            table->processes = realloc(table->processes, capacity * sizeof(process_spec_t));
+            assert(table->processes!=NULL);
+        }
+
+        process_spec_t *spec = &table->processes[table->count++];
+        spec->time_arrived = processes->time_arrived[p];
+        spec->service_time = processes->service_time[p];
+        spec->memory_requirement = processes->memory_requirement[p];
+        spec->name = arena_add_string(table->name_arena, process_name(processes, p), processes->name_length[p]);
+        spec->name_length = processes->name_length[p];
+        spec->text = text;
+
+        release_process(trace, p);
+    }
+
+    if (trace_error(trace)) {
+        snprintf(error, TRACE_ERROR_BYTES, "%s", trace_error(trace));
+        free_trace_table(table);
+        table = NULL;
+    }
+    close_trace(trace);
+    free_process_table(processes);
+    free_arena(name_arena);
+
+    return table;
+}
+
+void free_trace_table(trace_table_t *table) {
+    free(table->processes);
+    free_arena(table->name_arena);
+    free(table);
+}
@@ -0,0 +1,115 @@
+#ifndef _TRACE_H_
+#define _TRACE_H_
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<limits.h>
+#include<assert.h>
+#include<stdint.h>
+#include<fcntl.h>
+#include<unistd.h>
+#include<sys/mman.h>
+#include<sys/stat.h>
+#include"queues.h"
+#include"pool.h"
+
+#define TRACE_ERROR_BYTES 256
+
+// a trace line as read, newline included, to tell the trace a checkpoint was taken from
+typedef struct {
+    uint64_t hash;              // FNV-1a
+    uint64_t length;
+} trace_line_t;
+
+typedef struct {
+    handle_t p;
+    int64_t time_arrived;
+    int line;
+    trace_line_t text;
+} pending_process_t;
+
+// a process as read from the trace, before it is simulated
+typedef struct {
+    int64_t time_arrived;
+    int64_t service_time;
+    int64_t memory_requirement;
+    uint32_t name;              // in the table's name arena
+    int name_length;
+    trace_line_t text;
+} process_spec_t;
+
+// a whole trace parsed once, in arrival order, shared read only by any number of runs
+typedef struct {
+    process_spec_t *processes;
+    int count;
+    arena_t *name_arena;
+} trace_table_t;
+
+// processes read from an input file or stdin, handed out in order of arrival
+typedef struct {
+    char *filename;
+    int line_number;
+    uint32_t process_count;     // processes read so far, numbers the next one
+
+    // regular files are memory mapped and their names left in place, other input is read line
+    // by line and its names copied into the arena. A table keeps the names of its processes
+    const char *map;
+    size_t map_length;
+    const char *map_cursor;
+
+    FILE *file;
+    char *lineptr;
+    size_t line_buffer_length;
+
+    // or processes come from a table loaded beforehand
+    trace_table_t *table;
+    int table_next;
+
+    // or they are submitted one at a time, queued behind next
+    queue_t *submitted;
+
+    handle_t next;          // read ahead, the next process to be submitted
+    handle_t after;         // and the one after it, to check the order a process ahead
+    int64_t last_arrival;   // arrival time of the last process submitted
+    int64_t handed_out_arrival;     // and of the last process handed out, from any other source
+
+    // the lines of next, after and the last process read, and all those handed out hashed in turn
+    trace_line_t next_text, after_text, read_text;
+    trace_line_t consumed;
+
+    // set once a process arrives earlier than the one before it, the rest of the
+    // trace is then read in and stably sorted by arrival time. A mapped trace is
+    // checked, and sorted, before any process is handed out. Other input can only be
+    // sorted back to the last process handed out, an earlier line is an error
+    int unsorted;
+    pending_process_t *pending;
+    int pending_count;
+    int pending_next;
+
+    process_table_t *processes;
+    arena_t *name_arena;
+
+    // empty until a line cannot be parsed, the trace then ends before it
+    char error[TRACE_ERROR_BYTES];
+} trace_t;
+
+trace_t* open_trace(char *filename, process_table_t *processes, arena_t *name_arena);
+trace_t* open_table_trace(trace_table_t *table, process_table_t *processes);
+trace_t* open_submitted_trace(process_table_t *processes, arena_t *name_arena);
+handle_t trace_submit_process(trace_t *trace, const char *name, int name_length, int64_t time_arrived,
+     int64_t service_time, int64_t memory_requirement);
+void close_trace(trace_t *trace);
+int trace_is_empty(trace_t *trace);
+int trace_was_sorted(trace_t *trace);
+trace_line_t trace_consumed(trace_t *trace);
+const char* trace_error(trace_t *trace);
+int64_t trace_next_arrival(trace_t *trace);
+handle_t trace_next_process(trace_t *trace);
+void release_process(trace_t *trace, handle_t p);
+void skip_trace_processes(trace_t *trace, int64_t count);
+
+trace_table_t* load_trace_table(char *filename, char *error);
+void free_trace_table(trace_table_t *table);
+
+#endif
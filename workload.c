@@ -0,0 +1,22 @@
+#include<stdio.h>
+#include<stdlib.h>
+#include<stdint.h>
+#include<signal.h>
+#include<unistd.h>
+#include<sys/prctl.h>
+#include"executor.h"
+
+/* Stand-in program for allocate -x. It tells the manager it has started, then keeps a CPU busy
+   until it is killed, the manager stops and continues it as its process is switched */
+int main(int argc, char *argv[]) {
+    // do not outlive a manager that was killed itself
+    prctl(PR_SET_PDEATHSIG, SIGKILL);
+    if (getppid() == 1) return EXIT_FAILURE;
+
+    char started = 1;
+    if (write(WORKLOAD_READY_FD, &started, 1) != 1) return EXIT_FAILURE;
+    close(WORKLOAD_READY_FD);
+
+    volatile uint64_t spins = 0;
+    for (;;) spins++;
+}